@@ -18,6 +18,7 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include <elm/options.h>
 #include <elm/data/FragTable.h>
 #include <elm/data/HashMap.h>
@@ -37,24 +38,35 @@ public:
 			.free_argument("<file path>")
 			.help()),
 		list_files(option::Switch::Make(*this).cmd("-l").help("display file/line to code [default]")),
-		list_code(option::Switch::Make(*this).cmd("-c").help("display code to file/line"))
+		list_code(option::Switch::Make(*this).cmd("-c").help("display code to file/line")),
+		lookup(option::Switch::Make(*this).cmd("-a").help("display file/line of the addresses read from standard input"))
 	{ }
 
 	void run() override {
 		for(int i = 0; i < args.count(); i++)
 			try {
 				auto f = gel::Manager::open(args[i]);
-				auto dl = f->debugLines();
-				ASSERT(dl != nullptr);
-				
+
 				// set the address format
 				if(f->addressType() == gel::address_32)
 					addr_fmt.width(8);
 				else
 					addr_fmt.width(16);
 
+				// stream the code of ELF files
+				if(list_code && !lookup && f->toELF() != nullptr) {
+					CodeLister lister(addr_fmt);
+					elf::DebugLine::visit(f->toELF(), lister);
+					delete f;
+					continue;
+				}
+				auto dl = f->debugLines();
+				ASSERT(dl != nullptr);
+
 				// perform the action
-				if(list_code)
+				if(lookup)
+					lookupAddresses(dl);
+				else if(list_code)
 					listCode(dl);
 				else
 					listFiles(dl);
@@ -73,59 +85,68 @@ protected:
 
 private:
 
+	class CodeLister: public DebugLine::Visitor {
+	public:
+		inline CodeLister(io::IntFormat fmt): addr_fmt(fmt) { }
+		void processLine(const DebugLine::CompilationUnit& cu, const DebugLine::LineNumber& line) override {
+			if(!(line.flags() & DebugLine::LineNumber::END_SEQUENCE))
+				cout << addr_fmt(line.addr()) << "\t" << line.file()->path() << ":" << line.line() << io::endl;
+		}
+	private:
+		io::IntFormat addr_fmt;
+	};
+
 	void listFiles(DebugLine *dl) {
 		for(auto file: dl->files()) {
-
-			// collect addresses
-			HashMap<int, List<Pair<address_t, address_t> > *> addrs;
-			int min = type_info<int>::max, max = 0;
-			for(auto cu: file->units()) {
-				const auto& lines = cu->lines();
-				for(int i = 0; i < lines.count() - 1; i++)
-					if(file == lines[i].file()) {
-						auto l = addrs.get(lines[i].line(), nullptr);
-						if(l == nullptr) {
-							l = new List<Pair<address_t, address_t> >();
-							addrs.put(lines[i].line(), l);
-						}
-						l->add(pair(lines[i].addr(), lines[i + 1].addr()));
-						if(lines[i].line() < min)
-							min = lines[i].line();
-						else if(lines[i].line() > max)
-							max = lines[i].line();
-					}
+			int n = file->countRanges();
+			if(n == 0)
+				continue;
+			auto f = io::IntFormat().right().pad(' ').width(log10(max(1, file->range(n - 1).line)) + 1);
+			for(int i = 0; i < n; i++) {
+				const auto& r = file->range(i);
+				cout << file->path() << ":" << f(r.line)
+					 << "\t" << addr_fmt(r.low)
+					 << "-"  << addr_fmt(r.high) << io::endl;
 			}
-
-			// display the addresses
-			if(min <= max) {
-				auto f = io::IntFormat().right().pad(' ').width(log10(max) + 1);
-				for(int i = min; i <= max; i++)
-					if(addrs.hasKey(i)) {
-						auto l = addrs.get(i, nullptr);
-						if(l != nullptr)
-							for(auto a: *l)
-								cout << file->path() << ":" << f(i)
-									 << "\t" << addr_fmt(a.fst)
-									 << "-"  << addr_fmt(a.snd) << io::endl;
-					}
-			}
-
-			// clean all
-			for(auto l: addrs)
-				delete l;
 		}
 	}
 
 	void listCode(DebugLine *dl) {
 		for(auto cu: dl->units()) {
-			const auto& lines = cu->lines();
+			const auto& lines = cu->table();
 			for(int i = 0; i < lines.count() - 1; i++)
-				cout << addr_fmt(lines[i].addr()) << "\t" << lines[i].file()->path() << ":" << lines[i].line() << io::endl;
+				if(!(lines[i].flags() & DebugLine::LineNumber::END_SEQUENCE))
+					cout << addr_fmt(lines[i].addr()) << "\t" << lines[i].file()->path() << ":" << lines[i].line() << io::endl;
+		}
+	}
+
+	void lookupAddresses(DebugLine *dl) {
+
+		// read the addresses (one hexadecimal address per line)
+		Vector<address_t> addrs;
+		string line;
+		while(cin.scanLine(line)) {
+			cstring cs = line.toCString();
+			char *end;
+			auto a = strtoull(cs.chars(), &end, 16);
+			if(end != cs.chars())
+				addrs.add(a);
+		}
+
+		// look them up in one batch
+		Vector<DebugLine::LineNumber> lines;
+		dl->linesAt(addrs, lines);
+		for(int i = 0; i < addrs.count(); i++) {
+			cout << addr_fmt(addrs[i]) << "\t";
+			if(lines[i].file() == nullptr)
+				cout << "??" << io::endl;
+			else
+				cout << lines[i].file()->path() << ":" << lines[i].line() << io::endl;
 		}
 	}
 
 	io::IntFormat addr_fmt = io::IntFormat().pad('0').hex().right();
-	option::Switch list_files, list_code;
+	option::Switch list_files, list_code, lookup;
 	Vector<string> args;
 };
 
@@ -38,22 +38,20 @@ public:
 	{ }
 
 	void processELF(elf::File *f) {
-		for(int i = 0; i < f->sections().length(); i++) {
-			elf::Section *sect = f->sections()[i];
-			if(sect->type() == SHT_SYMTAB || sect->type() == SHT_DYNAMIC) {
+		for(auto sect: f->sections())
+			if(sect->type() == SHT_SYMTAB || sect->type() == SHT_DYNSYM) {
 				cout << "SECTION " << sect->name() << io::endl;
 				cout << "st_value st_size  binding type    st_shndx         name\n";
-				for(auto s: f->symbols()) {
-					auto sym = static_cast<elf::Symbol *>(s);
-					cout <<	word_fmt(sym->value())						<< ' '
-							<< word_fmt(sym->size()) 						<< ' '
-							<< io::fmt(sym->size()).width(7)				<< ' '
-							<< io::fmt(sym->elfType()).width(7)			<< ' '
-							<< io::fmt(get_section_index(f, *sym)).width(16)	<< ' '
-							<< sym->name()										<< io::endl;
+				for(auto i = f->syms(sect).begin(); !i.ended(); i.next()) {
+					const auto& sym = i.item();
+					cout <<	word_fmt(sym.value)							<< ' '
+							<< word_fmt(sym.size) 							<< ' '
+							<< io::fmt(get_binding(sym.info)).width(7)		<< ' '
+							<< io::fmt(get_type(sym.info)).width(7)			<< ' '
+							<< io::fmt(get_section_index(f, sym.shndx)).width(16)	<< ' '
+							<< i.name()										<< io::endl;
 				}
 			}
-		}
 	}
 
 	void processGen(File *file) {
@@ -105,50 +103,50 @@ private:
 
 	/**
 	 * Get the binding of a symbol.
-	 * @param infos		Information about the symbol.
+	 * @param info		Information about the symbol (st_info).
 	 * @return			Binding as a string.
 	 */
-	string get_binding(const elf::Elf32_Sym& infos) {
-		switch(ELF32_ST_BIND(infos.st_info)) {
+	string get_binding(t::uint8 info) {
+		switch(ELF32_ST_BIND(info)) {
 		case STB_LOCAL: 	return "local";
 		case STB_GLOBAL: 	return "global";
 		case STB_WEAK: 		return "weak";
-		default:			return _ << ELF32_ST_BIND(infos.st_info);
+		default:			return _ << ELF32_ST_BIND(info);
 		}
 	}
 
 	/**
 	 * Get the type of a symbol.
-	 * @param infos		Information about the symbol.
+	 * @param info		Information about the symbol (st_info).
 	 * @return			Type as a string.
 	 */
-	string get_type(const elf::Elf32_Sym& infos) {
-		switch(ELF32_ST_TYPE(infos.st_info)) {
+	string get_type(t::uint8 info) {
+		switch(ELF32_ST_TYPE(info)) {
 		case STT_NOTYPE: 	return "notype";
 		case STT_OBJECT: 	return "object";
 		case STT_FUNC: 		return "func";
 		case STT_SECTION:	return "section";
 		case STT_FILE: 		return "file";
-		default:			return _ << ELF32_ST_TYPE(infos.st_info);
+		default:			return _ << ELF32_ST_TYPE(info);
 		}
 	}
 
 	/**
 	 * Get a section as a text.
 	 * @param file		Current file.
-	 * @param infos		Information about the symbol.
+	 * @param shndx		Section index of the symbol.
 	 * @return			Section as a string.
 	 */
-	string get_section_index(elf::File *file, elf::Symbol& sym) {
-		switch(sym.shndx()) {
+	string get_section_index(elf::File *file, int shndx) {
+		switch(shndx) {
 		case SHN_UNDEF: 	return "undef";
 		case SHN_ABS: 		return "abs";
 		case SHN_COMMON:	return "common";
 		default: {
-			if(file->sections().length() <= sym.shndx())
-				return _ << sym.shndx();
+			if(file->sections().length() <= shndx)
+				return _ << shndx;
 			else
-				return file->sections()[sym.shndx()]->name();
+				return file->sections()[shndx]->name();
 			}
 		}
 	}
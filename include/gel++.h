@@ -19,6 +19,7 @@
 #ifndef GEL___H_
 #define GEL___H_
 
+#include <elm/data/Vector.h>
 #include <elm/sys/Path.h>
 #include <elm/util/ErrorHandler.h>
 #include <elm/io/RandomAccessStream.h>
@@ -36,15 +37,69 @@ namespace pecoff { class File; }
 
 class Manager: public ErrorBase {
 public:
+	typedef t::uint32 flags_t;
+	static const flags_t
+		MAP_FILES				= 0x01,
+		LAZY_DEBUG_LINES		= 0x02,
+		PARALLEL_DEBUG_LINES	= 0x04,
+		COMPACT_DEBUG_LINES		= 0x08;
+
+	class OpenOptions {
+	public:
+		static const OpenOptions null;
+		OpenOptions();
+		int threads;
+		bool load_headers;
+		bool load_sections;
+		bool load_symbols;
+	};
+
+	class Probe {
+	public:
+		typedef enum {
+			NO_FORMAT = 0,
+			ELF_FORMAT = 1,
+			PECOFF_FORMAT = 2
+		} format_t;
+		Probe();
+		inline bool isKnown() const { return format != NO_FORMAT; }
+		format_t format;
+		address_type_t address_type;
+		bool big_endian;
+		int machine;
+		int os;
+		File::type_t type;
+	};
+
+	class OpenResult {
+	public:
+		inline OpenResult(): file(nullptr) { }
+		inline bool succeeded() const { return file != nullptr; }
+		sys::Path path;
+		File *file;
+		string error;
+	};
+
 	inline static File *open(sys::Path path) { return DEFAULT.openFile(path); }
 	inline static elf::File *openELF(sys::Path path) { return DEFAULT.openELFFile(path); }
 
 	static Manager DEFAULT;
+	Manager(flags_t flags = 0);
+	inline flags_t flags() const { return _flags; }
+	inline void setFlags(flags_t flags) { _flags = flags; }
+	inline bool isSet(flags_t flags) const { return (_flags & flags) != 0; }
+
+	static Probe probe(sys::Path path);
 	File *openFile(sys::Path path);
 	elf::File *openELFFile(sys::Path path);
 	elf::File *openELFFile(sys::Path path, io::RandomAccessStream *stream);
 	pecoff::File *openPECOFFFile(sys::Path path, io::RandomAccessStream *stream);
-	
+	void openAll(const Vector<sys::Path>& paths, Vector<OpenResult>& results,
+		const OpenOptions& options = OpenOptions::null);
+
+private:
+	elf::File *makeELFFile(sys::Path path, t::uint8 *ident, io::RandomAccessStream *stream, int fd);
+	flags_t _flags;
 };
 
 }	// gel
@@ -22,7 +22,9 @@
 #include <elm/data/List.h>
 #include <elm/data/FragTable.h>
 #include <elm/data/HashMap.h>
+#include <mutex>
 #include <gel++.h>
+#include <gel++/IntervalIndex.h>
 
 namespace gel {
 
@@ -38,21 +40,35 @@ public:
 		friend class CompilationUnit;
 		friend class DebugLine;
 	public:
-		inline File(): _date(0), _size(0) { }
+
+		class LineRange {
+		public:
+			int line;
+			address_t low, high;
+		};
+
+		inline File(): _date(0), _size(0), _count(0), _ranges(nullptr) { }
 		inline File(sys::Path path, t::uint64 date = 0, size_t size = 0):
-			_path(path), _date(date), _size(size) { }
+			_path(path), _date(date), _size(size), _count(0), _ranges(nullptr) { }
+		~File();
 
 		inline const sys::Path& path() const { return _path; }
 		inline t::uint64 date() const { return _date; }
 		inline size_t size() const { return _size; }
 		inline const List<CompilationUnit *>& units() const { return _units; }
 		void find(int line, Vector<Pair<address_t, address_t> >& addrs) const;
+		int countRanges() const;
+		const LineRange& range(int i) const;
 
 	private:
+		void buildRanges() const;
 		sys::Path _path;
 		t::uint64 _date;
 		size_t _size;
 		List<CompilationUnit *> _units;
+		mutable std::once_flag _once;
+		mutable int _count;
+		mutable LineRange *_ranges;
 	};
 
 	class LineNumber {
@@ -61,7 +77,8 @@ public:
 			IS_STMT			= 1 << 0,
 			BASIC_BLOCK		= 1 << 1,
 			PROLOGUE_END	= 1 << 2,
-			EPILOGUE_BEGIN	= 1 << 3;
+			EPILOGUE_BEGIN	= 1 << 3,
+			END_SEQUENCE	= 1 << 4;
 
 		inline LineNumber()
 			: _file(nullptr), _line(0), _col(0), _flags(0), _addr(0), _isa(0),
@@ -87,20 +104,90 @@ public:
 		t::uint8 _isa, _disc, _opi;
 	};
 
+	class LineTable {
+	public:
+		LineTable();
+		~LineTable();
+
+		class Iter {
+		public:
+			inline Iter(const LineTable& t, int i): _t(t), _i(i) { }
+			inline LineNumber operator*() const { return _t[_i]; }
+			inline Iter& operator++() { _i++; return *this; }
+			inline bool operator!=(const Iter& it) const { return _i != it._i; }
+		private:
+			const LineTable& _t;
+			int _i;
+		};
+
+		inline int count() const { return _n; }
+		inline bool isCompact() const { return _addr != nullptr; }
+		inline const FragTable<LineNumber>& rows() const { return _lines; }
+		address_t addr(int i) const;
+		t::uint32 flags(int i) const;
+		LineNumber operator[](int i) const;
+		inline Iter begin() const { return Iter(*this, 0); }
+		inline Iter end() const { return Iter(*this, _n); }
+
+		void add(const LineNumber& line);
+		void compact(const Vector<File *>& files);
+
+	private:
+		static const int BLOCK_SHIFT = 6;
+		static const t::uint8 WIDE = 1 << 7;
+		int _n;
+		FragTable<LineNumber> _lines;
+		const Vector<File *> *_files;
+		address_t _base;
+		int *_line_base;
+		t::uint32 *_addr;
+		t::int16 *_line;
+		t::uint16 *_col, *_file;
+		t::uint8 *_flags, *_isa, *_disc, *_opi;
+		HashMap<int, LineNumber> _wide;
+	};
+
 	class CompilationUnit {
 		friend class DebugLine;
 	public:
-		const FragTable<LineNumber>& lines() const { return _lines; }
+		CompilationUnit();
+		virtual ~CompilationUnit();
+		const FragTable<LineNumber>& lines() const;
+		inline const LineTable& table() const { load(); return _lines; }
 		const Vector<File *>& files() const { return _files; }
 		void add(const LineNumber& num);
 		void add(File *file);
 		address_t baseAddress() const;
 		address_t topAddress() const;
 		inline size_t size() const { return topAddress() - baseAddress(); }
+		int countSequences() const;
+		range_t sequence(int i) const;
+		int find(address_t addr) const;
 		const LineNumber *lineAt(address_t addr) const;
+		bool lineAt(address_t addr, LineNumber& line) const;
+		inline bool isLazy() const { return _lazy != nullptr; }
+		inline void compact() { _lines.compact(_files); }
+	protected:
+		void setLazy(DebugLine *dl, const Vector<Pair<address_t, address_t> >& ranges);
 	private:
+		void load() const;
+		void index() const;
+		void buildSequences() const;
 		Vector<File *> _files;
-		FragTable<LineNumber> _lines;
+		LineTable _lines;
+		DebugLine *_lazy;
+		Vector<Pair<address_t, address_t> > _ranges;
+		mutable address_t _base, _top;
+		mutable std::once_flag _once, _seq_once;
+		mutable IntervalIndex<Pair<int, int> > _seqs;
+	};
+
+	class Visitor {
+	public:
+		virtual ~Visitor();
+		virtual void startUnit(const CompilationUnit& cu);
+		virtual void processLine(const CompilationUnit& cu, const LineNumber& line) = 0;
+		virtual void endUnit(const CompilationUnit& cu);
 	};
 
 	DebugLine(gel::File *file);
@@ -109,15 +196,22 @@ public:
 	inline const FragTable<CompilationUnit *>& units() const { return _cus; }
 	inline gel::File& program() const { return prog; }
 	const LineNumber *lineAt(address_t addr) const;
-	
+	bool lineAt(address_t addr, LineNumber& line) const;
+	void linesAt(const Vector<address_t>& addrs, Vector<LineNumber>& lines) const;
+
 protected:
 	virtual ~DebugLine();
 	void add(CompilationUnit *cu);
 	void add(File *file);
+	virtual void load(CompilationUnit *cu);
 	gel::File& prog;
 private:
+	int find(address_t addr, const CompilationUnit *& cu) const;
+	void buildIndex() const;
 	FragTable<CompilationUnit *> _cus;
 	HashMap<sys::Path, File *> _files;
+	mutable std::once_flag _index_once;
+	mutable IntervalIndex<const CompilationUnit *> _cu_index;
 };
 
 }	// gel
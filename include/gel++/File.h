@@ -20,6 +20,7 @@
 #ifndef GELPP_FILE_H_
 #define GELPP_FILE_H_
 
+#include <mutex>
 #include <elm/data/Array.h>
 #include <elm/data/HashMap.h>
 #include <elm/sys/Path.h>
@@ -104,6 +105,7 @@ public:
 };
 
 class DebugLine;
+class SymbolIndex;
 
 class File {
 public:
@@ -136,6 +138,8 @@ public:
 	virtual Section *section(int i);
 	
 	virtual const SymbolTable& symbols() = 0;
+	const SymbolIndex& symbolIndex();
+	Symbol *symbolAt(address_t a);
 	virtual DebugLine *debugLines();
 	virtual string machine() const;
 	virtual string os() const;
@@ -143,9 +147,12 @@ public:
 	virtual int elfOS() const;
 	
 protected:
+	virtual SymbolIndex *makeSymbolIndex();
 	Manager& man;
 private:
 	sys::Path _path;
+	std::once_flag _sym_index_once;
+	SymbolIndex *_sym_index;
 };
 
 io::Output& operator<<(io::Output& out, File::type_t t);
@@ -20,9 +20,11 @@
 #define GELPP_IMAGE_H_
 
 #include <elm/data/BiDiList.h>
+#include <elm/data/Vector.h>
 #include <elm/util/ErrorHandler.h>
 #include <gel++/base.h>
 #include <gel++/File.h>
+#include <gel++/IntervalIndex.h>
 
 namespace gel {
 
@@ -30,6 +32,7 @@ using namespace elm;
 class Image;
 
 class ImageSegment: public Segment {
+	friend class Image;
 public:
 	typedef t::uint32 flags_t;
 	static const flags_t
@@ -38,7 +41,10 @@ public:
 		READABLE	= 0x04,
 		CONTENT		= 0x08,
 		STACK		= 0x10,
-		TO_FREE		= 0x20;
+		TO_FREE		= 0x20,
+		SHARED		= 0x40,
+		ZERO_FILL	= 0x80;
+	static const int PAGE_BITS = 12;
 
 	ImageSegment(Buffer buf, address_t addr, flags_t flags, cstring name = "");
 	ImageSegment(File *file, Buffer buf, address_t addr, flags_t flags, cstring name = "");
@@ -48,11 +54,16 @@ public:
 	inline File *file() const { return _file; }
 	inline Segment *segment() const { return _seg; }
 	inline address_t base() const { return _base; }
-	inline const Buffer& buffer() const { return _buf; }
+	inline const Buffer& buffer() const { if(_pages != nullptr) materialize(); return _buf; }
 	inline range_t range() const { return range_t(_base, _buf.size()); }
 	inline flags_t flags() const { return _flags; }
 	inline bool isReadable() const { return _flags & READABLE; }
 	inline bool isStack() const { return _flags & STACK; }
+	inline Decoder *decoder() const { return _buf.decoder(); }
+	inline bool isShared() const { return _flags & SHARED; }
+	inline bool isPaged() const { return (_flags & SHARED) || _dirty != nullptr; }
+	inline int copiedPages() const { return _copied; }
+	t::uint8 *map(offset_t off, bool write, size_t& avail);
 
 	// Segment implementation
 	cstring name() override;
@@ -66,12 +77,19 @@ public:
 	Buffer buffer() override;
 
 private:
+	void materialize() const;
+	void track();
+	inline size_t pageCount() const { return (_buf.size() + (1 << PAGE_BITS) - 1) >> PAGE_BITS; }
 	cstring _name;
 	File *_file;
 	Segment *_seg;
 	address_t _base;
-	Buffer _buf;
-	flags_t _flags;
+	mutable Buffer _buf;
+	mutable flags_t _flags;
+	mutable t::uint8 **_pages;
+	mutable int _copied;
+	bool *_dirty;
+	Image *_im;
 };
 
 class Image {
@@ -97,10 +115,83 @@ public:
 	void add(ImageSegment *segment);
 	ImageSegment *at(address_t address);
 
+	static const int
+		PAGE_BITS = ImageSegment::PAGE_BITS,
+		TLB_SIZE = 64;
+
+	template <class T> inline T read(address_t a) {
+		T v;
+		const tlb_t& e = _tlb[(a >> PAGE_BITS) & (TLB_SIZE - 1)];
+		if(e.page == (a >> PAGE_BITS) && e.low <= a && a + sizeof(T) <= e.high) {
+			v = *(const T *)(e.mem + (a - e.base));
+			fix(e.dec, v);
+		}
+		else
+			fix(transfer(a, (t::uint8 *)&v, sizeof(T), false), v);
+		return v;
+	}
+
+	template <class T> inline void write(address_t a, T v) {
+		const tlb_t& e = _tlb[(a >> PAGE_BITS) & (TLB_SIZE - 1)];
+		if(e.page == (a >> PAGE_BITS) && e.write && e.low <= a && a + sizeof(T) <= e.high) {
+			unfix(e.dec, v);
+			*(T *)(e.mem + (a - e.base)) = v;
+		}
+		else {
+			ImageSegment *s = at(a);
+			if(s != nullptr)
+				unfix(s->decoder(), v);
+			transfer(a, (t::uint8 *)&v, sizeof(T), true);
+		}
+	}
+
+	class Snapshot {
+		friend class Image;
+	public:
+		~Snapshot();
+	private:
+		typedef struct seg_t {
+			ImageSegment *seg;
+			t::uint8 *data;
+		} seg_t;
+		inline Snapshot(Image *im): _im(im) { }
+		Image *_im;
+		Vector<seg_t> _segs;
+	};
+	Snapshot *snapshot();
+	void restore(Snapshot *snap);
+
+	inline void read(address_t a, void *dst, size_t n) { transfer(a, (t::uint8 *)dst, n, false); }
+	inline void write(address_t a, const void *src, size_t n) { transfer(a, (t::uint8 *)src, n, true); }
+	void flush();
+
 private:
+	typedef struct tlb_t {
+		address_t page;
+		address_t low, high;
+		address_t base;
+		t::uint8 *mem;
+		Decoder *dec;
+		bool write;
+	} tlb_t;
+
+	template <class T> inline static void fix(Decoder *d, T& v) { if(d != nullptr) d->fix(v); }
+	inline static void fix(Decoder *d, t::uint8& v) { }
+	inline static void fix(Decoder *d, t::int8& v) { }
+	template <class T> inline static void unfix(Decoder *d, T& v) { if(d != nullptr) d->unfix(v); }
+	inline static void unfix(Decoder *d, t::uint8& v) { }
+	inline static void unfix(Decoder *d, t::int8& v) { }
+
+	ImageSegment *lookup(address_t address);
+	Decoder *transfer(address_t a, t::uint8 *p, size_t n, bool write);
+	tlb_t _tlb[TLB_SIZE];
 	File *_prog;
 	BiDiList<link_t> _links;
 	BiDiList<ImageSegment *> segs;
+	IntervalIndex<ImageSegment *> _index;
+	bool _built;
+	ImageSegment *_last;
+	Snapshot *_snap;
 };
 
 class Parameter {
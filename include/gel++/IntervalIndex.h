@@ -0,0 +1,228 @@
+/*
+ * GEL++ IntervalIndex class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_INTERVAL_INDEX_H_
+#define GELPP_INTERVAL_INDEX_H_
+
+#include <algorithm>
+#include <elm/data/Vector.h>
+#include <gel++/base.h>
+
+namespace gel {
+
+/**
+ * Index of address intervals [low, high[ associated with a piece of data of
+ * type T: it answers the question "which interval contains address a?" in
+ * logarithmic time.
+ *
+ * The intervals are first recorded with add() and then indexed with build().
+ * They are sorted by start address and the start addresses are stored in an
+ * Eytzinger (breadth-first) layout that makes the binary search cache-friendly.
+ * Overlapping intervals are supported: the found interval is the one with
+ * the greatest start address containing the looked address.
+ *
+ * @param T		Type of data associated with the intervals.
+ * @ingroup gel
+ */
+template <class T>
+class IntervalIndex {
+public:
+	inline IntervalIndex()
+		: _n(0), _low(nullptr), _high(nullptr), _max(nullptr), _data(nullptr), _eyt(nullptr), _pos(nullptr) { }
+	inline ~IntervalIndex() { clear(); }
+
+	inline void add(address_t low, address_t high, const T& data)
+		{ item_t i = { low, high, data }; _items.add(i); }
+	void build();
+	void clear();
+
+	inline int count() const { return _n; }
+	inline address_t low(int i) const { ASSERT(0 <= i && i < _n); return _low[i]; }
+	inline address_t high(int i) const { ASSERT(0 <= i && i < _n); return _high[i]; }
+	inline const T& data(int i) const { ASSERT(0 <= i && i < _n); return _data[i]; }
+
+	int upperBound(address_t a) const;
+	int find(address_t a) const;
+	void findAll(const address_t *addrs, int n, int *res) const;
+
+private:
+	typedef struct item_t {
+		address_t low, high;
+		T data;
+	} item_t;
+	int layout(int i, int k);
+
+	Vector<item_t> _items;
+	int _n;
+	address_t *_low;
+	address_t *_high;
+	address_t *_max;
+	T *_data;
+	address_t *_eyt;
+	int *_pos;
+};
+
+
+/**
+ * Build the index from the intervals recorded by add(). Previous index,
+ * if any, is lost.
+ */
+template <class T>
+void IntervalIndex<T>::build() {
+	clear();
+	_n = _items.count();
+	if(_n == 0)
+		return;
+
+	// sort the intervals (stable to keep the insertion order of equal starts)
+	item_t *items = new item_t[_n];
+	for(int i = 0; i < _n; i++)
+		items[i] = _items[i];
+	_items.clear();
+	std::stable_sort(items, items + _n, [](const item_t& a, const item_t& b) {
+		return a.low < b.low;
+	});
+
+	// build the arrays
+	_low = new address_t[_n];
+	_high = new address_t[_n];
+	_max = new address_t[_n];
+	_data = new T[_n];
+	for(int i = 0; i < _n; i++) {
+		_low[i] = items[i].low;
+		_high[i] = items[i].high;
+		_data[i] = items[i].data;
+		_max[i] = i == 0 ? _high[i] : std::max(_max[i - 1], _high[i]);
+	}
+	delete [] items;
+
+	// build the Eytzinger layout
+	_eyt = new address_t[_n + 1];
+	_pos = new int[_n + 1];
+	layout(0, 1);
+}
+
+
+/**
+ * Release the index.
+ */
+template <class T>
+void IntervalIndex<T>::clear() {
+	if(_low != nullptr) {
+		delete [] _low;
+		delete [] _high;
+		delete [] _max;
+		delete [] _data;
+		delete [] _eyt;
+		delete [] _pos;
+		_low = nullptr;
+	}
+	_n = 0;
+}
+
+
+/**
+ * Build the Eytzinger layout of the sorted start addresses.
+ * @param i		Next sorted index to store.
+ * @param k		Current node in the Eytzinger array (1-based).
+ * @return		Next sorted index to store after the sub-tree at k.
+ */
+template <class T>
+int IntervalIndex<T>::layout(int i, int k) {
+	if(k <= _n) {
+		i = layout(i, 2 * k);
+		_eyt[k] = _low[i];
+		_pos[k] = i;
+		i++;
+		i = layout(i, 2 * k + 1);
+	}
+	return i;
+}
+
+
+/**
+ * Find the index of the first interval whose start address is greater than a.
+ * @param a		Looked address.
+ * @return		Index of the first interval after a (count() if there is none).
+ */
+template <class T>
+int IntervalIndex<T>::upperBound(address_t a) const {
+	int k = 1;
+	while(k <= _n)
+		k = 2 * k + (_eyt[k] <= a);
+	while(k & 1)
+		k >>= 1;
+	k >>= 1;
+	return k == 0 ? _n : _pos[k];
+}
+
+
+/**
+ * Find the interval containing the given address.
+ * @param a		Looked address.
+ * @return		Index of the interval (in the sorted order) or -1 if not found.
+ */
+template <class T>
+int IntervalIndex<T>::find(address_t a) const {
+	for(int i = upperBound(a) - 1; i >= 0 && _max[i] > a; i--)
+		if(_high[i] > a)
+			return i;
+	return -1;
+}
+
+
+/**
+ * Find the intervals containing each address of the given array. The
+ * addresses are sorted and merged with the sorted intervals: this is faster
+ * than n independent find() when n is big.
+ * @param addrs		Looked addresses (in any order).
+ * @param n			Number of addresses.
+ * @param res		Array of n integers receiving, for each address, the index
+ * 					of the containing interval or -1.
+ */
+template <class T>
+void IntervalIndex<T>::findAll(const address_t *addrs, int n, int *res) const {
+
+	// sort the addresses
+	int *perm = new int[n];
+	for(int i = 0; i < n; i++)
+		perm[i] = i;
+	std::sort(perm, perm + n, [addrs](int a, int b) {
+		return addrs[a] < addrs[b];
+	});
+
+	// merge with the intervals
+	int j = 0;
+	for(int k = 0; k < n; k++) {
+		address_t a = addrs[perm[k]];
+		while(j < _n && _low[j] <= a)
+			j++;
+		int r = -1;
+		for(int i = j - 1; i >= 0 && _max[i] > a; i--)
+			if(_high[i] > a) {
+				r = i;
+				break;
+			}
+		res[perm[k]] = r;
+	}
+	delete [] perm;
+}
+
+}	// gel
+
+#endif /* GELPP_INTERVAL_INDEX_H_ */
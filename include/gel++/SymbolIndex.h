@@ -0,0 +1,49 @@
+/*
+ * GEL++ SymbolIndex class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_SYMBOL_INDEX_H_
+#define GELPP_SYMBOL_INDEX_H_
+
+#include <gel++/File.h>
+#include <gel++/IntervalIndex.h>
+
+namespace gel {
+
+class SymbolIndex {
+public:
+	SymbolIndex(const SymbolTable& symtab);
+	SymbolIndex(const Vector<Symbol *>& syms);
+
+	inline int count() const { return _index.count(); }
+	inline Symbol *symbol(int i) const { return _index.data(i); }
+	inline address_t low(int i) const { return _index.low(i); }
+	inline address_t high(int i) const { return _index.high(i); }
+	inline range_t range(int i) const { return range_t(low(i), high(i) - low(i)); }
+
+	inline int find(address_t a) const { return _index.find(a); }
+	inline Symbol *lookup(address_t a) const
+		{ int i = find(a); return i < 0 ? nullptr : symbol(i); }
+
+private:
+	void build(const Vector<Symbol *>& syms);
+	IntervalIndex<Symbol *> _index;
+};
+
+} // gel
+
+#endif /* GELPP_SYMBOL_INDEX_H_ */
@@ -61,6 +61,8 @@ typedef enum {
 } address_type_t;
 
 io::IntFormat format(address_type_t t, address_t a);
+t::uint8 *allocZeroed(size_t size);
+void freeZeroed(t::uint8 *p, size_t size);
 inline io::Output& operator<<(io::Output& out, const range_t& r)
 	{ out << format(address_64, r.base()) << ':' << format(address_64, r.size()); return out; }
 
@@ -34,6 +34,17 @@ using namespace elm;
 class DebugLine: public gel::DebugLine {
 public:
 
+	class FileEntry {
+	public:
+		inline FileEntry(): key(0), date(0), size(0) { }
+		inline FileEntry(cstring d, cstring n, t::uint64 k, t::uint64 dt, size_t s)
+			: dir(d), name(n), key(k), date(dt), size(s) { }
+		cstring dir, name;
+		t::uint64 key;
+		t::uint64 date;
+		size_t size;
+	};
+
 	class StateMachine {
 	public:
 		inline StateMachine() { include_directories.add("."); }
@@ -47,9 +58,32 @@ public:
 			discriminator = 0;
 		bool end_sequence = false;
 		t::uint8 flags = 0;
+		bool is_64 = false;
+		t::uint16 version = 0;
+		t::uint8 address_size = 0;
+		bool default_is_stmt = false;
+		bool record_rows = true, record_files = true, loading = false;
+		int file_count = 0;
+		Vector<FileEntry> *collect = nullptr;
+		Visitor *visitor = nullptr;
+		address_t low = ~address_t(0), high = 0;
+		Vector<Pair<address_t, address_t> > ranges;
 		inline void set(t::uint8 m) { flags |= m; }
 		inline void clear(t::uint8 m) { flags &= ~m; }
 		inline bool bit(t::uint8 m) { return (flags & m) != 0; }
+		inline void reset() {
+			address = 0;
+			op_index = 0;
+			file = 1;
+			line = 1;
+			column = 0;
+			isa = 0;
+			discriminator = 0;
+			end_sequence = false;
+			flags = default_is_stmt ? LineNumber::IS_STMT : 0;
+			low = ~address_t(0);
+			high = 0;
+		}
 		t::int8 line_base = 0;
 		t::uint8
 			line_range = 0,
@@ -59,6 +93,7 @@ public:
 			minimum_instruction_length = 0,
 			maximum_operations_per_instruction = 0;
 		Vector<cstring> include_directories;
+		Vector<t::uint64> dir_keys;
 		// initialize from program header 
 		bool basic_block = false;		// DWARF-5? (TODO)
 		bool prologue_end = false;		// DWARF-5 (TODO)
@@ -66,24 +101,59 @@ public:
 	};
 
 	DebugLine(elf::File *efile);
+	static void visit(elf::File *efile, Visitor& visitor);
+
+protected:
+	void load(CompilationUnit *cu) override;
 
 private:
-	void readCU(Cursor& c);
+
+	class Unit: public CompilationUnit {
+	public:
+		inline Unit(size_t off): offset(off) { }
+		~Unit() override;
+		inline void init(DebugLine *dl, const Vector<Pair<address_t, address_t> >& ranges)
+			{ setLazy(dl, ranges); }
+		inline void own(File *file) { add(file); owned.add(file); }
+		size_t offset;
+		Vector<File *> owned;
+	};
+
+	DebugLine(elf::File *efile, Visitor& visitor);
+	void readCU(Cursor& c, bool lazy);
+	void visitCU(Cursor& c, Visitor& visitor);
+	void readParallel(Cursor& c, bool lazy);
+	void readARanges(elf::File *efile);
+	void clearARanges();
+	bool readStmtList(elf::Section *info, elf::Section *abbrev, size_t offset, size_t& stmt);
 	void readHeader(Cursor& c, StateMachine& sm, CompilationUnit *cu);
 	void runSM(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t end);
+	void runSequence(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t end);
 	void advancePC(StateMachine& sm, CompilationUnit *cu, t::uint64 adv);
 	void advanceLine(StateMachine& sm, t::int64 adv);
 	void recordLine(StateMachine& sm, CompilationUnit *cu);
-	bool readFile(Cursor& c, StateMachine& sm, CompilationUnit *cu);
-	size_t readHeaderLength(Cursor& c);
-	size_t readUnitLength(Cursor& c);
+	bool readFile(Cursor& c, StateMachine& sm, CompilationUnit *cu, bool define = false);
+	void readEntries(Cursor& c, StateMachine& sm, CompilationUnit *cu);
+	void readFormat(Cursor& c, Vector<Pair<t::uint64, t::uint64> >& format);
+	void readString(Cursor& c, StateMachine& sm, t::uint64 form, cstring& s, t::uint64& key);
+	cstring stringAt(elf::Section *sect, size_t off);
+	t::uint64 readUData(Cursor& c, StateMachine& sm, t::uint64 form);
+	void skipForm(Cursor& c, StateMachine& sm, t::uint64 form);
+	void addFile(const FileEntry& e, StateMachine& sm, CompilationUnit *cu, bool define);
+	File *intern(const FileEntry& e);
+	size_t readOffset(Cursor& c, StateMachine& sm);
+	size_t readUnitLength(Cursor& c, StateMachine& sm);
 	t::int64 readLEB128S(Cursor& c);
 	t::uint64 readLEB128U(Cursor& c);
 	inline static void error_if(bool cond)
 		{ if(cond) throw gel::Exception("debug line error"); }
-	address_t readAddress(Cursor& c);
+	address_t readAddress(Cursor& c, int size);
 
-	bool is_64;
+	elf::Section *sect, *line_str, *str;
+	HashMap<t::uint64, File *> interned;
+	HashMap<t::uint64, Vector<Pair<address_t, address_t> > *> aranges;
+	bool compact;
+	std::mutex files_lock;
 };
 
 } }	// gel::elf
@@ -19,6 +19,7 @@
 #ifndef GELPP_ELF_FILE_H_
 #define GELPP_ELF_FILE_H_
 
+#include <mutex>
 #include <elm/data/HashMap.h>
 #include <elm/data/List.h>
 #include <elm/data/Vector.h>
@@ -30,6 +31,7 @@
 namespace gel { namespace elf {
 
 class DebugLine;
+class FlatSymbolTable;
 	
 class ProgramHeader {
 public:
@@ -50,11 +52,14 @@ public:
 
 protected:
 	virtual t::uint8 *readBuf() = 0;
-	inline void readAt(t::uint32 pos, void *buf, t::uint32 size);
+	inline void readAt(offset_t pos, void *buf, size_t size);
 
 private:
 	elf::File *_file;
 	t::uint8 *_buf;
+	size_t _size;
+	bool _mapped;
+	std::once_flag _once;
 };
 
 
@@ -79,12 +84,14 @@ public:
 
 protected:
 	virtual t::uint8 *readBuf() = 0;
-	inline void readAt(t::uint32 pos, void *buf, t::uint32 size);
+	inline void readAt(offset_t pos, void *buf, size_t size);
 	inline elf::File *file() const { return _file; }
 
 private:
 	elf::File *_file;
 	t::uint8 *buf;
+	bool mapped;
+	std::once_flag once;
 };
 
 class Symbol: public gel::Symbol {
@@ -107,8 +114,11 @@ class SymbolTable: public gel::SymbolTable {
 public:
 	~SymbolTable();
 	void record(elm::t::uint8 *mem);
+	void add(Symbol *sym, bool dynamic);
+	inline const Vector<gel::Symbol *>& all(bool dynamic) const { return dynamic ? dsyms : ssyms; }
 private:
 	List<elm::t::uint8 *> mems;
+	Vector<gel::Symbol *> ssyms, dsyms;
 };
 
 class DynEntry {
@@ -124,15 +134,29 @@ class File: public gel::File, public Decoder {
 	friend class ProgramHeader;
 	friend class Section;
 	friend class Segment;
+	friend class FlatSymbolTable;
 public:
-	File(Manager& manager, sys::Path path, io::RandomAccessStream *stream);
+	typedef struct sym_t {
+		t::uint32 name;
+		t::uint8 info;
+		t::uint8 other;
+		t::uint16 shndx;
+		t::uint64 value;
+		t::uint64 size;
+	} sym_t;
+
+	File(Manager& manager, sys::Path path, io::RandomAccessStream *stream, int fd = -1);
 	virtual ~File(void);
 	static bool matches(t::uint8 magic[4]);
+	static type_t typeOf(int elf_type);
 
 	virtual int elfType() = 0;
 	virtual t::uint16 version() = 0;
 	virtual const t::uint8 *ident() = 0;
 
+	bool map();
+	inline bool isMapped() const { return map_buf != nullptr; }
+
 	typedef Vector<Section *>::Iter SecIter;
 	Vector<Section *>& sections(void);
 	inline Section *sectionAt(int i) const { return sects[i]; }
@@ -149,6 +173,8 @@ public:
 
 	const gel::SymbolTable& symbols() override;
 	virtual void fillSymbolTable(SymbolTable& symtab, Section *sect) = 0;
+	const FlatSymbolTable& flatSymbols();
+	bool findDynamic(cstring name, sym_t& sym);
 
 	// gel::File overload
 	File *toELF() override;
@@ -176,6 +202,7 @@ public:
 	void unfix(t::int64& w) override;
 
 protected:
+	SymbolIndex *makeSymbolIndex() override;
 	inline void setIdent(t::uint8 *i) { id = i; }
 	virtual void loadProgramHeaders(Vector<ProgramHeader *>& headers) = 0;
 	virtual void loadSections(Vector<Section *>& segments) = 0;
@@ -189,19 +216,22 @@ protected:
 		} un;
 	} dyn_t;
 	virtual void fetchDyn(const t::uint8 *entry, dyn_t& dyn) = 0;
+	virtual void fetchSym(const t::uint8 *entry, sym_t& sym) = 0;
 
-	void read(void *buf, t::uint32 size);
-	void readAt(t::uint32 pos, void *buf, t::uint32 size);
+	void read(void *buf, size_t size);
+	void readAt(offset_t pos, void *buf, size_t size);
+	t::uint8 *mapAt(offset_t offset, size_t size);
 
 public:
 	// iterators
 	class EntryIter {
 	public:
 		inline EntryIter(File& file, Section *sec, bool ended = false)
-			: f(file), s(sec->entsize()), c(sec->content()) { }
-		inline bool ended() const { return !c.avail(s); }
+			: f(file), s(sec->entsize()), c(sec->content())
+			{ if(ended || s == 0 || !c.avail(s)) c.finish(); }
+		inline bool ended() const { return s == 0 || !c.avail(s); }
 		inline const t::uint8 *item() const { return c.here(); }
-		inline void next() { c.skip(s); }
+		inline void next() { c.skip(s); if(!c.avail(s)) c.finish(); }
 		inline bool equals(const EntryIter& i) const { return c.equals(i.c); }
 	protected:
 		File &f;
@@ -213,27 +243,53 @@ public:
 	public:
 		DynIter(File& file, Section *sec, bool ended = false);
 		inline const dyn_t& item() const { return d; }
-		inline void next() { EntryIter::next(); if(!c.ended()) f.fetchDyn(c.here(), d); }
+		inline void next() { EntryIter::next(); if(!ended()) f.fetchDyn(c.here(), d); }
 	private:
 		dyn_t d;
 	};
 	Range<DynIter> dyns();
 	Range<DynIter> dyns(Section *sect);
 
+	class SymIter: public EntryIter, public PreIterator<SymIter, sym_t> {
+	public:
+		SymIter(File& file, Section *sec, bool ended = false);
+		inline const sym_t& item() const { return sym; }
+		inline void next() { EntryIter::next(); if(!ended()) f.fetchSym(c.here(), sym); }
+		cstring name() const;
+	private:
+		sym_t sym;
+		Buffer str;
+	};
+	Range<SymIter> syms(Section *sect);
+
 private:
 	void initSections();
 	void initSegments();
+	void unmap();
+	bool lookupHash(cstring name, sym_t& sym);
+	bool lookupGNUHash(cstring name, sym_t& sym);
+	bool matchDynamic(Section *dynsym, t::uint32 i, cstring name, sym_t& sym);
 
 	io::RandomAccessStream *s;
+	std::mutex s_lock;
+	int fd;
+	t::uint8 *map_buf;
+	size_t map_size;
 	t::uint8 *id;
-	bool ph_loaded;
+	std::once_flag ph_once;
 	Vector<ProgramHeader *> phs;
-	bool sects_loaded;
+	std::once_flag sects_once;
 	Vector<Section *> sects;
 	Section *str_tab;
-	SymbolTable *syms;
+	std::once_flag sym_once;
+	SymbolTable *sym_tab;
+	std::once_flag flat_once;
+	FlatSymbolTable *flat_syms;
+	std::once_flag hash_once;
+	Section *hash_sect;
+	std::once_flag segs_once;
 	Vector<Segment *> segs;
-	bool segs_init;
+	std::once_flag debug_once;
 	DebugLine *debug;
 };
 
@@ -260,9 +316,9 @@ private:
 };
 
 inline Decoder *ProgramHeader::decoder(void) const { return _file; }
-inline void ProgramHeader::readAt(t::uint32 pos, void *buf, t::uint32 size)
+inline void ProgramHeader::readAt(offset_t pos, void *buf, size_t size)
 	{ _file->readAt(pos, buf, size); }
-inline void Section::readAt(t::uint32 pos, void *buf, t::uint32 size)
+inline void Section::readAt(offset_t pos, void *buf, size_t size)
 	{ _file->readAt(pos, buf, size); }
 
 } }	// gel::elf
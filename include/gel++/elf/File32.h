@@ -79,7 +79,7 @@ class File32: public elf::File {
 	friend class ProgramHeader32;
 	friend class Section32;
 public:
-	File32(Manager& manager, sys::Path path, io::RandomAccessStream *stream);
+	File32(Manager& manager, sys::Path path, io::RandomAccessStream *stream, int fd = -1);
 	~File32(void);
 
 	const Elf32_Ehdr& info(void) const { return *h; }
@@ -102,6 +102,7 @@ protected:
 	void loadSections(Vector<Section *>& sections) override;
 	int getStrTab() override;
 	void fetchDyn(const t::uint8 *entry, dyn_t& dyn) override;
+	void fetchSym(const t::uint8 *entry, sym_t& sym) override;
 
 private:
 	Elf32_Ehdr *h;
@@ -79,7 +79,7 @@ class File64: public elf::File {
 	friend class ProgramHeader64;
 	friend class Section64;
 public:
-	File64(Manager& manager, sys::Path path, io::RandomAccessStream *stream);
+	File64(Manager& manager, sys::Path path, io::RandomAccessStream *stream, int fd = -1);
 	~File64(void);
 
 	const Elf64_Ehdr& info(void) const { return *h; }
@@ -102,6 +102,7 @@ protected:
 	void loadSections(Vector<Section *>& sections) override;
 	int getStrTab() override;
 	void fetchDyn(const t::uint8 *entry, dyn_t& dyn) override;
+	void fetchSym(const t::uint8 *entry, sym_t& sym) override;
 
 private:
 	Elf64_Ehdr *h;
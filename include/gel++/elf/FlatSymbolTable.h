@@ -0,0 +1,111 @@
+/*
+ * gel::elf::FlatSymbolTable class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_ELF_FLAT_SYMBOL_TABLE_H_
+#define GELPP_ELF_FLAT_SYMBOL_TABLE_H_
+
+#include <mutex>
+#include <elm/data/Vector.h>
+#include "File.h"
+
+namespace gel { namespace elf {
+
+class FlatSymbolTable;
+
+class FlatSymbol {
+public:
+	inline FlatSymbol(): _tab(nullptr), _i(-1) { }
+	inline FlatSymbol(const FlatSymbolTable *tab, int i): _tab(tab), _i(i) { }
+	inline bool isNull() const { return _tab == nullptr; }
+	inline operator bool() const { return !isNull(); }
+	inline int index() const { return _i; }
+	inline bool equals(const FlatSymbol& s) const { return _tab == s._tab && _i == s._i; }
+	inline bool operator==(const FlatSymbol& s) const { return equals(s); }
+	inline bool operator!=(const FlatSymbol& s) const { return !equals(s); }
+
+	cstring name() const;
+	inline t::uint64 value() const;
+	inline t::uint64 size() const;
+	inline t::uint8 elfBind() const;
+	inline t::uint8 elfType() const;
+	inline int shndx() const;
+	gel::Symbol::type_t type() const;
+	gel::Symbol::bind_t bind() const;
+
+private:
+	const FlatSymbolTable *_tab;
+	int _i;
+};
+
+class FlatSymbolTable {
+	friend class FlatSymbol;
+public:
+	FlatSymbolTable(File& file);
+	~FlatSymbolTable();
+
+	inline File& file() const { return _file; }
+	inline int count() const { return _count; }
+	inline FlatSymbol operator[](int i) const { ASSERT(0 <= i && i < _count); return FlatSymbol(this, i); }
+	FlatSymbol find(cstring name) const;
+
+	class Iter: public PreIterator<Iter, FlatSymbol> {
+	public:
+		inline Iter(const FlatSymbolTable& tab, bool end = false): t(tab), i(end ? tab._count : 0) { }
+		inline bool ended() const { return i >= t._count; }
+		inline FlatSymbol item() const { return FlatSymbol(&t, i); }
+		inline void next() { i++; }
+		inline bool equals(const Iter& it) const { return &t == &it.t && i == it.i; }
+	private:
+		const FlatSymbolTable& t;
+		int i;
+	};
+	inline Iter begin() const { return Iter(*this); }
+	inline Iter end() const { return Iter(*this, true); }
+
+private:
+	typedef struct strtab_t {
+		int first;
+		Buffer buf;
+	} strtab_t;
+
+	int fill(int i, Section *sect);
+	cstring nameOf(int i) const;
+	void sortNames() const;
+
+	File& _file;
+	int _count;
+	t::uint8 *_arena;
+	t::uint64 *_value;
+	t::uint64 *_size;
+	t::uint32 *_name;
+	t::uint16 *_shndx;
+	t::uint8 *_info;
+	Vector<strtab_t> _strtabs;
+	mutable std::once_flag _by_name_once;
+	mutable t::uint32 *_by_name;
+};
+
+inline t::uint64 FlatSymbol::value() const { return _tab->_value[_i]; }
+inline t::uint64 FlatSymbol::size() const { return _tab->_size[_i]; }
+inline t::uint8 FlatSymbol::elfBind() const { return ELF32_ST_BIND(_tab->_info[_i]); }
+inline t::uint8 FlatSymbol::elfType() const { return ELF32_ST_TYPE(_tab->_info[_i]); }
+inline int FlatSymbol::shndx() const { return _tab->_shndx[_i]; }
+
+} }	// gel::elf
+
+#endif /* GELPP_ELF_FLAT_SYMBOL_TABLE_H_ */
@@ -0,0 +1,150 @@
+/*
+ * gel::elf::Reader class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_ELF_READER_H_
+#define GELPP_ELF_READER_H_
+
+#include "defs.h"
+#include "defs64.h"
+
+namespace gel { namespace elf {
+
+#ifdef BIGENDIAN
+#	define ELFDATAHOST	ELFDATA2MSB
+#else
+#	define ELFDATAHOST	ELFDATA2LSB
+#endif
+
+template <int D>
+class Order {
+public:
+	static const int data = D;
+	static const bool native = D == ELFDATAHOST;
+
+	static inline void fix(t::uint8& v) { }
+	static inline void fix(t::int8& v) { }
+	static inline void fix(t::uint16& v) { if(!native) v = t::uint16(SWAP2(v)); }
+	static inline void fix(t::int16& v) { if(!native) v = t::int16(SWAP2(t::uint16(v))); }
+	static inline void fix(t::uint32& v) { if(!native) v = t::uint32(SWAP4(v)); }
+	static inline void fix(t::int32& v) { if(!native) v = t::int32(SWAP4(t::uint32(v))); }
+	static inline void fix(t::uint64& v) { if(!native) v = t::uint64(SWAP8(v)); }
+	static inline void fix(t::int64& v) { if(!native) v = t::int64(SWAP8(t::uint64(v))); }
+};
+
+typedef Order<ELFDATA2LSB> LittleOrder;
+typedef Order<ELFDATA2MSB> BigOrder;
+
+class Class32 {
+public:
+	static const int id = ELFCLASS32;
+	typedef Elf32_Ehdr Ehdr;
+	typedef Elf32_Shdr Shdr;
+	typedef Elf32_Phdr Phdr;
+	typedef Elf32_Sym Sym;
+	typedef Elf32_Dyn Dyn;
+};
+
+class Class64 {
+public:
+	static const int id = ELFCLASS64;
+	typedef Elf64_Ehdr Ehdr;
+	typedef Elf64_Shdr Shdr;
+	typedef Elf64_Phdr Phdr;
+	typedef Elf64_Sym Sym;
+	typedef Elf64_Dyn Dyn;
+};
+
+template <class C, class O>
+class Reader {
+public:
+	typedef typename C::Ehdr Ehdr;
+	typedef typename C::Shdr Shdr;
+	typedef typename C::Phdr Phdr;
+	typedef typename C::Sym Sym;
+	typedef typename C::Dyn Dyn;
+
+	template <class T> static inline T get(T v) { O::fix(v); return v; }
+
+	static inline void fix(Ehdr& h) {
+		O::fix(h.e_type);
+		O::fix(h.e_machine);
+		O::fix(h.e_version);
+		O::fix(h.e_entry);
+		O::fix(h.e_phoff);
+		O::fix(h.e_shoff);
+		O::fix(h.e_flags);
+		O::fix(h.e_ehsize);
+		O::fix(h.e_phentsize);
+		O::fix(h.e_phnum);
+		O::fix(h.e_shentsize);
+		O::fix(h.e_shnum);
+		O::fix(h.e_shstrndx);
+	}
+
+	static inline void fix(Shdr& s) {
+		O::fix(s.sh_name);
+		O::fix(s.sh_type);
+		O::fix(s.sh_flags);
+		O::fix(s.sh_addr);
+		O::fix(s.sh_offset);
+		O::fix(s.sh_size);
+		O::fix(s.sh_link);
+		O::fix(s.sh_info);
+		O::fix(s.sh_addralign);
+		O::fix(s.sh_entsize);
+	}
+
+	static inline void fix(Phdr& p) {
+		O::fix(p.p_type);
+		O::fix(p.p_flags);
+		O::fix(p.p_offset);
+		O::fix(p.p_vaddr);
+		O::fix(p.p_paddr);
+		O::fix(p.p_filesz);
+		O::fix(p.p_memsz);
+		O::fix(p.p_align);
+	}
+
+	static inline void fix(Sym& s) {
+		O::fix(s.st_name);
+		O::fix(s.st_value);
+		O::fix(s.st_size);
+		O::fix(s.st_shndx);
+	}
+
+	static inline void fix(Dyn& d) {
+		O::fix(d.d_tag);
+		O::fix(d.d_un.d_val);
+	}
+
+	static void fixSections(t::uint8 *buf, int n, size_t entsize)
+		{ for(int i = 0; i < n; i++) fix(*reinterpret_cast<Shdr *>(buf + i * entsize)); }
+	static void fixProgramHeaders(t::uint8 *buf, int n, size_t entsize)
+		{ for(int i = 0; i < n; i++) fix(*reinterpret_cast<Phdr *>(buf + i * entsize)); }
+	static void fixSymbols(t::uint8 *buf, size_t size, size_t entsize)
+		{ for(size_t o = 0; o + entsize <= size; o += entsize) fix(*reinterpret_cast<Sym *>(buf + o)); }
+};
+
+typedef Reader<Class32, LittleOrder> Reader32L;
+typedef Reader<Class32, BigOrder> Reader32B;
+typedef Reader<Class64, LittleOrder> Reader64L;
+typedef Reader<Class64, BigOrder> Reader64B;
+
+} }	// gel::elf
+
+#endif /* GELPP_ELF_READER_H_ */
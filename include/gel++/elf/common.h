@@ -93,6 +93,7 @@ namespace gel { namespace elf {
 #define SHT_SHLIB		10
 #define SHT_DYNSYM		11
 #define SHT_LOOS		0x60000000
+#define SHT_GNU_HASH	0x6FFFFFF6
 #define SHT_HIOS		0x6FFFFFFF
 #define LOPROC			0x70000000
 #define HIPROC			0x7FFFFFFF
@@ -104,6 +105,9 @@ namespace gel { namespace elf {
 #define SHF_MASKOS		0x0F000000
 #define SHF_MASKPROC	0xF0000000
 
+// Symbol Table Index
+#define STN_UNDEF	0
+
 // Symbol Bindings
 #define STB_LOCAL	0
 #define STB_GLOBAL	1
@@ -186,6 +190,7 @@ namespace gel { namespace elf {
 // end no more
 
 #define DT_LOOS		0x60000000
+#define DT_GNU_HASH	0x6ffffef5	/* d_ptr */
 #define DT_HIOS		0x6fffffff
 #define DT_LOPROC	0x70000000
 #define DT_HIPROC	0x7fffffff
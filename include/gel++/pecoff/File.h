@@ -191,6 +191,9 @@ public:
 	File(Manager& manager, sys::Path path, io::RandomAccessStream *stream);
 	~File(void);
 	static bool matches(t::uint8 magic[4]);
+	static type_t typeOf(t::uint16 characteristics);
+	static address_type_t addressTypeOf(t::uint16 characteristics, t::uint16 magic);
+	static int elfMachineOf(t::uint16 machine);
 	
 	type_t type(void) override;
 	bool isBigEndian(void) override;
@@ -225,6 +228,7 @@ private:
 	void read(void *buf, int len);
 	void move(offset_t offset);
 	cstring getString(t::uint32 offset);
+	void readSymbols(SymbolTable& symtab);
 	
 	io::RandomAccessStream *stream;
 	coff_header_t _coff_header;
@@ -236,6 +240,7 @@ private:
 	char *_string_table;
 	t::uint32 _string_table_size;
 	Vector<Section *> sects;
+	SymbolTable *_symtab;
 };
 
 } } // gel::pecoff
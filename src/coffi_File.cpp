@@ -33,10 +33,11 @@ namespace gel { namespace coffi {
 ///
 class Symbol: public gel::Symbol {
 public:
-	Symbol(File& file, type_t type, bind_t bind, COFFI::symbol& sym)
-		: _file(file), _type(type), _bind(bind), _sym(sym) {}
-	cstring name() override { return _sym.get_name().c_str(); }
-	t::uint64 value() override { return _sym.get_value(); }
+	Symbol(File& file, type_t type, bind_t bind, COFFI::symbol& sym, address_t value)
+		: _file(file), _type(type), _bind(bind), _sym(sym), _value(value),
+		  _name(sym.get_name().c_str()) {}
+	cstring name() override { return _name.toCString(); }
+	t::uint64 value() override { return _value; }
 	t::uint64 size() override { return 0; }
 	type_t type() override { return _type; }
 	bind_t bind() override { return _bind; }
@@ -45,6 +46,8 @@ private:
 	type_t _type;
 	bind_t _bind;
 	COFFI::symbol& _sym;
+	address_t _value;
+	string _name;
 };
 
 
@@ -244,25 +247,45 @@ Image *File::make(const Parameter& params) {
 	// TODO
 }
 
-///
+/**
+ * Get the symbols of the file. Only the symbols defined in a section
+ * and with an external, static or weak external storage class are
+ * considered. Their value is converted to an address in the loaded image.
+ */
 const SymbolTable& File::symbols() {
 	if(_symtab == nullptr) {
 		_symtab = new SymbolTable;
-
-		// find text and data
-		auto _text = -1, _data = -1;
-		for(int i = 0; i < _reader->get_sections().size(); i++) {
-			auto name = _reader->get_sections()[i]->get_name();
-			if(name == ".text")
-				_text = i;
-			else if(name == ".data")
-				_data = i;
-		}
-
-		// build symbols
-		for(auto s: _reader->get_sections()) {
-			cerr << "DEBUG:" << s->get_name().c_str() << io::endl;
-			cerr << "DEBUG:" << s->value << io::endl;
+		auto& sects = _reader->get_sections();
+		for(auto& sym: *_reader->get_symbols()) {
+			t::int16 sn = sym.get_section_number();
+			if(sn <= 0 || sn > int(sects.size()))
+				continue;
+
+			// get binding
+			gel::Symbol::bind_t bind;
+			switch(sym.get_storage_class()) {
+			case IMAGE_SYM_CLASS_EXTERNAL:		bind = gel::Symbol::GLOBAL; break;
+			case IMAGE_SYM_CLASS_STATIC:		bind = gel::Symbol::LOCAL; break;
+			case IMAGE_SYM_CLASS_WEAK_EXTERNAL:	bind = gel::Symbol::WEAK; break;
+			default:							continue;
+			}
+
+			// get type
+			auto sect = sects[sn - 1];
+			gel::Symbol::type_t type;
+			if((sym.get_type() >> 4) == IMAGE_SYM_DTYPE_FUNCTION
+			|| (sect->get_flags() & IMAGE_SCN_MEM_EXECUTE) != 0)
+				type = gel::Symbol::FUNC;
+			else
+				type = gel::Symbol::DATA;
+
+			// build the symbol
+			auto s = new Symbol(*this, type, bind, sym,
+				_base + sect->get_virtual_address() + sym.get_value());
+			if(_symtab->hasKey(s->name()))
+				delete s;
+			else
+				_symtab->put(s->name(), s);
 		}
 	}
 	return *_symtab;
@@ -17,6 +17,9 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <atomic>
+#include <thread>
+#include <elm/compare.h>
 #include <elm/data/util.h>
 
 #include "../include/gel++/elf/DebugLine.h"
@@ -51,7 +54,7 @@ namespace gel { namespace elf {
 #define DW_LNE_define_file			3
 #define DW_LNE_set_discriminator	4		/* DWARF-4 */
 
-// Standard Content Description (DWARF-5, TODO)
+// Standard Content Description (DWARF-5)
 #define DW_LNCT_path				0x1
 #define DW_LNCT_directory_index		0x2
 #define DW_LNCT_timestamp			0x3
@@ -72,14 +75,45 @@ namespace gel { namespace elf {
 #define DW_FORM_flag			0x0c
 #define DW_FORM_sdata			0x0d
 #define DW_FORM_strp			0x0e
-	
-#define DW_FORM_line_strp
-#define DW_FORM_strp_sup
-#define DW_FORM_strx
-#define DW_FORM_strx1
-#define DW_FORM_strx2
-#define DW_FORM_strx3
-#define DW_FORM_strx4
+#define DW_FORM_udata			0x0f
+#define DW_FORM_ref_addr		0x10
+#define DW_FORM_ref1			0x11
+#define DW_FORM_ref2			0x12
+#define DW_FORM_ref4			0x13
+#define DW_FORM_ref8			0x14
+#define DW_FORM_ref_udata		0x15
+#define DW_FORM_indirect		0x16
+#define DW_FORM_sec_offset		0x17	/* DWARF-4 */
+#define DW_FORM_exprloc			0x18	/* DWARF-4 */
+#define DW_FORM_flag_present	0x19	/* DWARF-4 */
+#define DW_FORM_strx			0x1a	/* DWARF-5 */
+#define DW_FORM_addrx			0x1b	/* DWARF-5 */
+#define DW_FORM_ref_sup4		0x1c	/* DWARF-5 */
+#define DW_FORM_strp_sup		0x1d	/* DWARF-5 */
+#define DW_FORM_data16			0x1e	/* DWARF-5 */
+#define DW_FORM_line_strp		0x1f	/* DWARF-5 */
+#define DW_FORM_ref_sig8		0x20	/* DWARF-4 */
+#define DW_FORM_implicit_const	0x21	/* DWARF-5 */
+#define DW_FORM_loclistx		0x22	/* DWARF-5 */
+#define DW_FORM_rnglistx		0x23	/* DWARF-5 */
+#define DW_FORM_ref_sup8		0x24	/* DWARF-5 */
+#define DW_FORM_strx1			0x25	/* DWARF-5 */
+#define DW_FORM_strx2			0x26	/* DWARF-5 */
+#define DW_FORM_strx3			0x27	/* DWARF-5 */
+#define DW_FORM_strx4			0x28	/* DWARF-5 */
+#define DW_FORM_addrx1			0x29	/* DWARF-5 */
+#define DW_FORM_addrx2			0x2a	/* DWARF-5 */
+#define DW_FORM_addrx3			0x2b	/* DWARF-5 */
+#define DW_FORM_addrx4			0x2c	/* DWARF-5 */
+
+// Attributes
+#define DW_AT_stmt_list			0x10
+
+// Unit types (DWARF-5)
+#define DW_UT_compile			0x01
+#define DW_UT_partial			0x03
+#define DW_UT_skeleton			0x04
+#define DW_UT_split_compile		0x05
 	
 	
 /**
@@ -91,24 +125,97 @@ namespace gel { namespace elf {
 /**
  * @class DebugLine
  * Provides access to debug source line information of an ELF file.
+ *
+ * If the flag @ref Manager::LAZY_DEBUG_LINES is set, the line programs are
+ * only skimmed at build time to get the address range of the compilation
+ * units and the rows of a compilation unit are only decoded and stored
+ * when the unit is accessed.
+ *
+ * In lazy mode, if the file provides .debug_aranges, the address ranges of
+ * the compilation units are taken from this section (through the
+ * DW_AT_stmt_list attribute of the units in .debug_info) and the line
+ * programs of these units are not even skimmed (units without any range in
+ * .debug_aranges are skimmed anyway).
+ *
+ * If the flag @ref Manager::PARALLEL_DEBUG_LINES is set, the compilation
+ * units are decoded in parallel by a pool of threads.
+ *
+ * If the flag @ref Manager::COMPACT_DEBUG_LINES is set, the rows of each
+ * compilation unit are put in compact form as soon as they are decoded.
  */
 
 /**
  * Build source line debug information for the given ELF file.
  * @param efile
  */
-DebugLine::DebugLine(elf::File *efile): gel::DebugLine(efile), is_64(false) {
+DebugLine::DebugLine(elf::File *efile)
+:	gel::DebugLine(efile),
+	sect(nullptr),
+	line_str(nullptr),
+	str(nullptr),
+	compact(efile->manager().isSet(Manager::COMPACT_DEBUG_LINES))
+{
 
 	// get the buffer
-	elf::Section *sect = efile->findSection(".debug_line");
+	sect = efile->findSection(".debug_line");
 	if(sect == nullptr)
 		return;
+	line_str = efile->findSection(".debug_line_str");
+	str = efile->findSection(".debug_str");
 	Cursor c(sect->content());
 
 	// decode the content
 	DEBUG("reading (size =" << c.size() << ")");
+	bool lazy = efile->manager().isSet(Manager::LAZY_DEBUG_LINES);
+	if(lazy)
+		readARanges(efile);
+	try {
+		if(efile->manager().isSet(Manager::PARALLEL_DEBUG_LINES))
+			readParallel(c, lazy);
+		else
+			while(!c.ended())
+				readCU(c, lazy);
+	}
+	catch(gel::Exception& e) {
+		clearARanges();
+		throw;
+	}
+	clearARanges();
+}
+
+/**
+ * Build a debug line information only used to stream the lines to the
+ * given visitor.
+ * @param efile		Current ELF file.
+ * @param visitor	Visitor to pass the lines to.
+ */
+DebugLine::DebugLine(elf::File *efile, Visitor& visitor)
+:	gel::DebugLine(efile),
+	sect(nullptr),
+	line_str(nullptr),
+	str(nullptr),
+	compact(false)
+{
+	sect = efile->findSection(".debug_line");
+	if(sect == nullptr)
+		return;
+	line_str = efile->findSection(".debug_line_str");
+	str = efile->findSection(".debug_str");
+	Cursor c(sect->content());
 	while(!c.ended())
-		readCU(c);
+		visitCU(c, visitor);
+}
+
+/**
+ * Decode the lines of the given ELF file and pass them to the visitor
+ * as soon as they are decoded, instead of storing them. Only the current
+ * compilation unit and its files are kept in memory: this allows
+ * one-pass processing of debug information of any size.
+ * @param efile		ELF file to process.
+ * @param visitor	Visitor receiving the lines.
+ */
+void DebugLine::visit(elf::File *efile, Visitor& visitor) {
+	DebugLine dl(efile, visitor);
 }
 
 /**
@@ -123,21 +230,31 @@ DebugLine::DebugLine(elf::File *efile): gel::DebugLine(efile), is_64(false) {
  * @return	List of compilation units.
  */
 
-void DebugLine::readCU(Cursor& c) {
+DebugLine::Unit::~Unit() {
+	for(auto f: owned)
+		delete f;
+}
+
+void DebugLine::readCU(Cursor& c, bool lazy) {
 	StateMachine sm;
+	sm.record_rows = !lazy;
 
 	// start the compilation unit
-	size_t unit_length = readUnitLength(c);
+	size_t offset = c.offset();
+	size_t unit_length = readUnitLength(c, sm);
 	size_t end_offset = c.offset() + unit_length;
 	DEBUG("===> unit_length = " << unit_length
 		 << ", end offset = " << end_offset);
-	auto cu = new CompilationUnit();
+	auto cu = new Unit(offset);
 
 	// parse the header
+	auto ranges = lazy ? aranges.get(offset, nullptr) : nullptr;
+	if(ranges != nullptr && ranges->count() == 0)
+		ranges = nullptr;
 	try {
 		readHeader(c, sm, cu);
 		DEBUG("readHeader: file = " << sm.file);
-		if(c.offset() < end_offset)
+		if(ranges == nullptr && c.offset() < end_offset)
 			runSM(c, sm, cu, end_offset);
 	}
 	catch(gel::Exception& e) {
@@ -146,26 +263,375 @@ void DebugLine::readCU(Cursor& c) {
 	}
 
 	// finalize
+	if(lazy)
+		cu->init(this, ranges != nullptr ? *ranges : sm.ranges);
+	else if(compact)
+		cu->compact();
 	add(cu);
 	c.move(end_offset);
 }
 
+
+/**
+ * Decode a compilation unit and pass its lines to the visitor. The files
+ * of the unit are private to it and released at the end of the unit.
+ * @param c			Cursor on the unit.
+ * @param visitor	Visitor to pass the lines to.
+ */
+void DebugLine::visitCU(Cursor& c, Visitor& visitor) {
+	StateMachine sm;
+	sm.visitor = &visitor;
+	size_t unit_length = readUnitLength(c, sm);
+	size_t end_offset = c.offset() + unit_length;
+	CompilationUnit cu;
+	try {
+		readHeader(c, sm, &cu);
+		visitor.startUnit(cu);
+		if(c.offset() < end_offset)
+			runSM(c, sm, &cu, end_offset);
+		visitor.endUnit(cu);
+	}
+	catch(gel::Exception& e) {
+		for(auto f: cu.files())
+			delete f;
+		throw;
+	}
+	for(auto f: cu.files())
+		delete f;
+	c.move(end_offset);
+}
+
+
+/**
+ * Read .debug_aranges to get the address ranges of the line programs
+ * (by offset in .debug_line). If the section is missing or inconsistent,
+ * no range is recorded and all the units are skimmed.
+ * @param efile		Current ELF file.
+ */
+void DebugLine::readARanges(elf::File *efile) {
+	auto ar = efile->findSection(".debug_aranges");
+	auto info = efile->findSection(".debug_info");
+	auto abbrev = efile->findSection(".debug_abbrev");
+	if(ar == nullptr || info == nullptr || abbrev == nullptr)
+		return;
+	try {
+		Cursor c(ar->content());
+		while(!c.ended()) {
+
+			// read the set header
+			StateMachine ctx;
+			size_t start = c.offset();
+			size_t length = readUnitLength(c, ctx);
+			size_t end = c.offset() + length;
+			t::uint16 version;
+			t::uint8 address_size, segment_selector_size;
+			error_if(!c.read(version));
+			size_t info_offset = readOffset(c, ctx);
+			error_if(!c.read(address_size));
+			error_if(!c.read(segment_selector_size));
+			size_t tuple = 2 * address_size;
+			size_t stmt;
+			if(segment_selector_size != 0 || tuple == 0
+			|| !readStmtList(info, abbrev, info_offset, stmt)) {
+				c.move(end);
+				continue;
+			}
+			auto v = aranges.get(stmt, nullptr);
+			if(v == nullptr) {
+				v = new Vector<Pair<address_t, address_t> >();
+				aranges.put(stmt, v);
+			}
+
+			// read the tuples (aligned on the tuple size)
+			error_if(!c.skip((tuple - (c.offset() - start) % tuple) % tuple));
+			while(c.offset() + tuple <= end) {
+				address_t a = readAddress(c, address_size);
+				address_t l = readAddress(c, address_size);
+				if(a == 0 && l == 0)
+					break;
+				if(l != 0)
+					v->add(pair(a, a + l));
+			}
+			c.move(end);
+		}
+	}
+	catch(gel::Exception& e) {
+		clearARanges();
+	}
+}
+
+/**
+ * Release the ranges read from .debug_aranges.
+ */
+void DebugLine::clearARanges() {
+	for(auto v: aranges)
+		delete v;
+	aranges.clear();
+}
+
+/**
+ * Get the offset of the line program of a compilation unit from its
+ * DW_AT_stmt_list attribute.
+ * @param info		.debug_info section.
+ * @param abbrev	.debug_abbrev section.
+ * @param offset	Offset of the compilation unit in .debug_info.
+ * @param stmt		Set to the offset of the line program.
+ * @return			True if the line program is found, false else.
+ */
+bool DebugLine::readStmtList(elf::Section *info, elf::Section *abbrev, size_t offset, size_t& stmt) {
+	StateMachine ctx;
+
+	// read the unit header
+	Cursor c(info->content());
+	error_if(!c.move(offset));
+	readUnitLength(c, ctx);
+	error_if(!c.read(ctx.version));
+	size_t abbrev_offset;
+	if(ctx.version >= 5) {
+		t::uint8 type;
+		error_if(!c.read(type));
+		error_if(!c.read(ctx.address_size));
+		abbrev_offset = readOffset(c, ctx);
+		if(type == DW_UT_skeleton || type == DW_UT_split_compile)
+			error_if(!c.skip(8));
+		else if(type != DW_UT_compile && type != DW_UT_partial)
+			return false;
+	}
+	else {
+		abbrev_offset = readOffset(c, ctx);
+		error_if(!c.read(ctx.address_size));
+	}
+	auto code = readLEB128U(c);
+
+	// find the abbreviation of the unit DIE
+	Cursor a(abbrev->content());
+	error_if(!a.move(abbrev_offset));
+	while(true) {
+		auto acode = readLEB128U(a);
+		if(acode == 0)
+			return false;
+		readLEB128U(a);
+		t::uint8 children;
+		error_if(!a.read(children));
+		if(acode == code)
+			break;
+		while(true) {
+			auto name = readLEB128U(a);
+			auto form = readLEB128U(a);
+			if(name == 0 && form == 0)
+				break;
+			if(form == DW_FORM_implicit_const)
+				readLEB128S(a);
+		}
+	}
+
+	// look for DW_AT_stmt_list
+	while(true) {
+		auto name = readLEB128U(a);
+		auto form = readLEB128U(a);
+		if(name == 0 && form == 0)
+			return false;
+		if(form == DW_FORM_implicit_const) {
+			auto v = readLEB128S(a);
+			if(name == DW_AT_stmt_list) {
+				stmt = v;
+				return true;
+			}
+			continue;
+		}
+		if(form == DW_FORM_indirect)
+			form = readLEB128U(c);
+		if(name == DW_AT_stmt_list) {
+			stmt = form == DW_FORM_sec_offset ? readOffset(c, ctx) : readUData(c, ctx, form);
+			return true;
+		}
+		skipForm(c, ctx, form);
+	}
+}
+
+
+/**
+ * Apply f to the integers in [0, n[ using a pool of threads.
+ * @param n		Number of jobs.
+ * @param f		Job function (taking the job number).
+ */
+template <class F>
+static void parallelFor(int n, F f) {
+	std::atomic<int> next(0);
+	auto work = [&]() {
+		for(int i = next++; i < n; i = next++)
+			f(i);
+	};
+	int tn = max(1, min(int(std::thread::hardware_concurrency()), n));
+	std::thread *pool = new std::thread[tn - 1];
+	for(int i = 0; i < tn - 1; i++)
+		pool[i] = std::thread(work);
+	work();
+	for(int i = 0; i < tn - 1; i++)
+		pool[i].join();
+	delete [] pool;
+}
+
+
+/**
+ * Decode the compilation units in parallel. This is performed in three
+ * phases: (1) the headers are parsed in parallel to collect the source files,
+ * (2) the source files are merged in the shared file map and (3) the line
+ * programs are run in parallel. Only the rare DW_LNE_define_file opcode
+ * needs to lock the file map during phase (3). Any error raised by a worker
+ * is recorded and the first one is thrown once all workers are joined.
+ * @param c		Cursor on the .debug_line section.
+ * @param lazy	If true, compilation units are only skimmed.
+ * @throw gel::Exception	If a compilation unit cannot be decoded.
+ */
+void DebugLine::readParallel(Cursor& c, bool lazy) {
+
+	// split the section into units
+	Vector<size_t> offsets;
+	while(!c.ended()) {
+		StateMachine sm;
+		offsets.add(c.offset());
+		size_t unit_length = readUnitLength(c, sm);
+		c.move(c.offset() + unit_length);
+	}
+	int n = offsets.count();
+	if(n == 0)
+		return;
+	auto files = new Vector<FileEntry>[n];
+	auto units = new Unit *[n];
+	auto errors = new string[n];
+
+	// (1) collect the source files
+	parallelFor(n, [&](int i) {
+		try {
+			StateMachine sm;
+			sm.collect = &files[i];
+			Cursor uc(sect->content());
+			uc.move(offsets[i]);
+			readUnitLength(uc, sm);
+			readHeader(uc, sm, nullptr);
+		}
+		catch(gel::Exception& e) {
+			errors[i] = e.message();
+		}
+		catch(MessageException& e) {
+			errors[i] = e.message();
+		}
+		catch(std::exception& e) {
+			errors[i] = e.what();
+		}
+		catch(...) {
+			errors[i] = "unexpected error";
+		}
+	});
+
+	// (2) merge the source files
+	bool failed = false;
+	for(int i = 0; i < n; i++) {
+		units[i] = new Unit(offsets[i]);
+		if(errors[i] != "")
+			failed = true;
+		else
+			for(const auto& e: files[i])
+				units[i]->add(intern(e));
+	}
+	delete [] files;
+
+	// (3) run the line programs
+	if(!failed)
+		parallelFor(n, [&](int i) {
+			try {
+				StateMachine sm;
+				sm.record_rows = !lazy;
+				sm.record_files = false;
+				Cursor uc(sect->content());
+				uc.move(offsets[i]);
+				size_t unit_length = readUnitLength(uc, sm);
+				size_t end_offset = uc.offset() + unit_length;
+				auto ranges = lazy ? aranges.get(offsets[i], nullptr) : nullptr;
+				if(ranges != nullptr && ranges->count() == 0)
+					ranges = nullptr;
+				readHeader(uc, sm, units[i]);
+				if(ranges == nullptr && uc.offset() < end_offset)
+					runSM(uc, sm, units[i], end_offset);
+				if(lazy)
+					units[i]->init(this, ranges != nullptr ? *ranges : sm.ranges);
+				else if(compact)
+					units[i]->compact();
+			}
+			catch(gel::Exception& e) {
+				errors[i] = e.message();
+			}
+			catch(MessageException& e) {
+				errors[i] = e.message();
+			}
+			catch(std::exception& e) {
+				errors[i] = e.what();
+			}
+			catch(...) {
+				errors[i] = "unexpected error";
+			}
+		});
+
+	// finalize
+	string error;
+	for(int i = 0; i < n && error == ""; i++)
+		error = errors[i];
+	delete [] errors;
+	if(error != "") {
+		for(int i = 0; i < n; i++)
+			delete units[i];
+		delete [] units;
+		throw gel::Exception(error);
+	}
+	for(int i = 0; i < n; i++)
+		add(units[i]);
+	delete [] units;
+}
+
+
+/**
+ * Decode the rows of a lazy compilation unit. This may be called from any
+ * thread (once per unit): the shared file table is only read and the files
+ * of the unit have already been recorded when it was skimmed, except those
+ * of DW_LNE_define_file opcodes of units not skimmed, that are kept private
+ * to the unit.
+ * @param cu	Compilation unit to decode.
+ */
+void DebugLine::load(CompilationUnit *cu) {
+	StateMachine sm;
+	sm.record_files = false;
+	sm.loading = true;
+	Cursor c(sect->content());
+	c.move(static_cast<Unit *>(cu)->offset);
+	size_t unit_length = readUnitLength(c, sm);
+	size_t end_offset = c.offset() + unit_length;
+	readHeader(c, sm, cu);
+	if(c.offset() < end_offset)
+		runSM(c, sm, cu, end_offset);
+	if(compact)
+		cu->compact();
+}
+
 void DebugLine::readHeader(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
 
 	// skip version
 	t::uint16 version;
 	error_if(!c.read(version));
-	static_cast<elf::File&>(prog).fix(version);
 	DEBUG("version = " << version);
-	if(version > 4)
-		throw gel::Exception(_ << "DWARF version > 4 (" << version << ")");
+	if(version > 5)
+		throw gel::Exception(_ << "DWARF version > 5 (" << version << ")");
+	sm.version = version;
+
+	// DWARF-5 address and segment selector size
+	if(version >= 5) {
+		t::uint8 segment_selector_size;
+		error_if(!c.read(sm.address_size));
+		error_if(!c.read(segment_selector_size));
+	}
 
-	// DWARF-5 (TODO)
-	// address_size (ubyte)
-	// segment_selector_size (ubyte)
-	
 	// read header length
-	size_t header_length = readHeaderLength(c);
+	size_t header_length = readOffset(c, sm);
 	size_t lines = c.offset() + header_length;
 	DEBUG("header length = " << io::hex(header_length));
 
@@ -179,7 +645,8 @@ void DebugLine::readHeader(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
 	// SM initialization
 	t::uint8 default_is_stmt;
 	c.read(default_is_stmt);
-	if(default_is_stmt)
+	sm.default_is_stmt = default_is_stmt != 0;
+	if(sm.default_is_stmt)
 		sm.set(LineNumber::IS_STMT);
 	DEBUG("default_is_stmt = " << sm.bit(LineNumber::IS_STMT));
 	c.read(sm.line_base);
@@ -198,35 +665,53 @@ void DebugLine::readHeader(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
 #		endif
 	c.skip(sm.opcode_base - 1);
 
-	// DWARF-5 new organisation (TODO)
-	// directory_entry_format_count (ubyte)
-	// directory_entry_format (ULEB128 pair list)
-	// directories_count (ULEB128)
-	// directories (string list)
-	// filename_entry_format_count (ubyte)
-	// file_name_entry_format (ULEB128 pair list)
-	// file_names_count(ULEB128)
-	// file_name(string list)
-	
+	// DWARF-5 new organisation
+	if(version >= 5)
+		readEntries(c, sm, cu);
+
 	// include directories
-	cstring s;
-	do {
-		error_if(!c.read(s));
-		if(s)
-			sm.include_directories.add(s);
-		DEBUG("include directory = " << s);
-	} while(s);
+	else {
+		cstring s;
+		do {
+			error_if(!c.read(s));
+			if(s)
+				sm.include_directories.add(s);
+			DEBUG("include directory = " << s);
+		} while(s);
 
-	// file names
-	while(readFile(c, sm, cu))
-		;
+		// file names
+		while(readFile(c, sm, cu))
+			;
+	}
 
 	// ensure at end of header
 	DEBUG("after header " << c.offset());
 	c.move(lines);
 }
 
+/**
+ * Run the line program of a compilation unit: each sequence is run in turn
+ * until the end of the unit.
+ * @param c		Cursor on the line program.
+ * @param sm	State machine initialized by the header.
+ * @param cu	Current compilation unit.
+ * @param end	End offset of the unit.
+ */
 void DebugLine::runSM(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t end) {
+	while(c.offset() < end) {
+		runSequence(c, sm, cu, end);
+		sm.reset();
+	}
+}
+
+/**
+ * Run one sequence of a line program, that is, until a DW_LNE_end_sequence.
+ * @param c		Cursor on the line program.
+ * @param sm	State machine.
+ * @param cu	Current compilation unit.
+ * @param end	End offset of the unit.
+ */
+void DebugLine::runSequence(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t end) {
 	while(!sm.end_sequence) {
 		if(c.offset() >= end)
 			throw gel::Exception("endless debug line opcode program");
@@ -279,7 +764,6 @@ void DebugLine::runSM(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t e
 			case DW_LNS_fixed_advance_pc: {
 					t::uint16 o;
 					error_if(!c.read(o));
-					static_cast<elf::File&>(prog).fix(o);
 					sm.address += o;
 					sm.op_index = 0;
 				}
@@ -295,20 +779,24 @@ void DebugLine::runSM(Cursor& c, StateMachine& sm, CompilationUnit *cu, size_t e
 				break;
 
 			case 0: {
-					int offset = readLEB128U(c);
-					offset += c.offset();
+					int size = readLEB128U(c);
+					int offset = size + c.offset();
 					error_if(!c.read(opcode));
 					DEBUG("extended " << opcode);
 					switch(opcode) {
 					case DW_LNE_end_sequence:
-						recordLine(sm, cu);
 						sm.end_sequence = true;
+						recordLine(sm, cu);
+						if(!sm.record_rows && sm.low < sm.high)
+							sm.ranges.add(pair(sm.low, sm.high));
 						break;
 					case DW_LNE_set_address:
-						sm.address = readAddress(c);
+						sm.address = readAddress(c, size - 1);
 						break;
-					case DW_LNE_define_file:
-						readFile(c, sm, cu);
+					case DW_LNE_define_file: {
+							std::lock_guard<std::mutex> guard(files_lock);
+							readFile(c, sm, cu, true);
+						}
 						break;
 					case DW_LNE_set_discriminator:
 						sm.discriminator = readLEB128U(c);
@@ -341,22 +829,32 @@ void DebugLine::advanceLine(StateMachine& sm, t::int64 adv) {
 
 void DebugLine::recordLine(StateMachine& sm, CompilationUnit *cu) {
 	DEBUG("file = " << sm.file);
-	File *file = cu->files()[sm.file - 1];
+	int index = sm.version >= 5 ? sm.file : sm.file - 1;
+	error_if(index < 0 || index >= cu->files().count());
+	File *file = cu->files()[index];
 	DEBUG("line "
 		<< io::hex(sm.address) << " "
 		<< file->path() << ":"
 		<< sm.line << ":" << sm.column);
 
-	// record the line
-	cu->add(LineNumber(sm.address, file, sm.line,
-			sm.column, sm.flags, sm.isa, sm.discriminator, sm.op_index));
+	// record the line (or only its address when skimming)
+	if(sm.visitor != nullptr)
+		sm.visitor->processLine(*cu, LineNumber(sm.address, file, sm.line,
+			sm.column, sm.flags | (sm.end_sequence ? LineNumber::END_SEQUENCE : 0), sm.isa, sm.discriminator, sm.op_index));
+	else if(!sm.record_rows) {
+		sm.low = min(sm.low, sm.address);
+		sm.high = max(sm.high, sm.address);
+	}
+	else
+		cu->add(LineNumber(sm.address, file, sm.line,
+			sm.column, sm.flags | (sm.end_sequence ? LineNumber::END_SEQUENCE : 0), sm.isa, sm.discriminator, sm.op_index));
 
 	// update the SM
 	sm.set(LineNumber::BASIC_BLOCK | LineNumber::PROLOGUE_END | LineNumber::EPILOGUE_BEGIN);
 	sm.discriminator = 0;
 }
 
-bool DebugLine::readFile(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
+bool DebugLine::readFile(Cursor& c, StateMachine& sm, CompilationUnit *cu, bool define) {
 	cstring s;
 	error_if(!c.read(s));
 	if(s == "")
@@ -365,53 +863,295 @@ bool DebugLine::readFile(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
 	auto date = readLEB128U(c);
 	auto size = readLEB128U(c);
 	DEBUG("file = " << s << ", " << dir << ", " << date << ", " << size);
-	sys::Path p;
-	if(dir == 0) {
-		p = sys::Path(".") / sys::Path(s);
-		DEBUG("no dire: " << p <<);
+	error_if(dir >= t::uint64(sm.include_directories.count()));
+	addFile(FileEntry(sm.include_directories[dir], s, 0, date, size), sm, cu, define);
+	return true;
+}
+
+/**
+ * Read the directory and file entries of a DWARF-5 line program header.
+ * @param c		Cursor on the header.
+ * @param sm	Current state machine.
+ * @param cu	Current compilation unit.
+ */
+void DebugLine::readEntries(Cursor& c, StateMachine& sm, CompilationUnit *cu) {
+	Vector<Pair<t::uint64, t::uint64> > format;
+
+	// directories (the first one is the compilation directory)
+	readFormat(c, format);
+	auto count = readLEB128U(c);
+	sm.include_directories.clear();
+	sm.dir_keys.clear();
+	for(t::uint64 i = 0; i < count; i++) {
+		cstring dir;
+		t::uint64 key = 0;
+		for(const auto& f: format)
+			if(f.fst == DW_LNCT_path)
+				readString(c, sm, f.snd, dir, key);
+			else
+				skipForm(c, sm, f.snd);
+		DEBUG("include directory = " << dir);
+		sm.include_directories.add(dir);
+		sm.dir_keys.add(key);
 	}
-	else {
-		DEBUG(dir << ":" << sm.include_directories[dir]);
-		p = sys::Path(sm.include_directories[dir]) / s;
-		DEBUG("p = " << p);
+
+	// files (the first one is the primary source file)
+	readFormat(c, format);
+	count = readLEB128U(c);
+	for(t::uint64 i = 0; i < count; i++) {
+		cstring name;
+		t::uint64 key = 0, dir = 0, date = 0, size = 0;
+		for(const auto& f: format)
+			switch(f.fst) {
+			case DW_LNCT_path:				readString(c, sm, f.snd, name, key); break;
+			case DW_LNCT_directory_index:	dir = readUData(c, sm, f.snd); break;
+			case DW_LNCT_timestamp:			date = readUData(c, sm, f.snd); break;
+			case DW_LNCT_size:				size = readUData(c, sm, f.snd); break;
+			default:						skipForm(c, sm, f.snd); break;
+			}
+		DEBUG("file = " << name << ", " << dir << ", " << date << ", " << size);
+		error_if(dir >= t::uint64(sm.include_directories.count()));
+
+		// build the interning key from the string offsets of the directory and name
+		t::uint64 dkey = sm.dir_keys[dir];
+		if(key != 0 && dkey != 0 && key <= 0xffffffff && dkey <= 0xffffffff)
+			key = (dkey << 32) | key;
+		else
+			key = 0;
+		addFile(FileEntry(sm.include_directories[dir], name, key, date, size), sm, cu, false);
 	}
-	DEBUG("p = " << (void *)&p << ":");
+}
+
+/**
+ * Read the entry format of DWARF-5 directory or file entries.
+ * @param c			Cursor on the header.
+ * @param format	Filled with pairs (content type, form).
+ */
+void DebugLine::readFormat(Cursor& c, Vector<Pair<t::uint64, t::uint64> >& format) {
+	t::uint8 count;
+	error_if(!c.read(count));
+	format.clear();
+	for(int i = 0; i < count; i++) {
+		auto type = readLEB128U(c);
+		auto form = readLEB128U(c);
+		format.add(pair(type, form));
+	}
+}
+
+/**
+ * Read a string attribute of a DWARF-5 entry.
+ * @param c		Cursor on the entry.
+ * @param sm	Current state machine.
+ * @param form	Form of the attribute.
+ * @param s		Set to the read string.
+ * @param key	Set to the offset of the string in .debug_line_str plus 1
+ * 				(used for interning) or to 0.
+ */
+void DebugLine::readString(Cursor& c, StateMachine& sm, t::uint64 form, cstring& s, t::uint64& key) {
+	key = 0;
+	switch(form) {
+	case DW_FORM_string:
+		error_if(!c.read(s));
+		break;
+	case DW_FORM_line_strp: {
+			auto off = readOffset(c, sm);
+			s = stringAt(line_str, off);
+			key = off + 1;
+		}
+		break;
+	case DW_FORM_strp:
+		s = stringAt(str, readOffset(c, sm));
+		break;
+	default:
+		throw gel::Exception(_ << "unsupported debug line string form " << form);
+	}
+}
+
+/**
+ * Get a string from a string section.
+ * @param sect	String section.
+ * @param off	Offset of the string in the section.
+ * @return		Found string.
+ */
+cstring DebugLine::stringAt(elf::Section *sect, size_t off) {
+	error_if(sect == nullptr);
+	Buffer buf = sect->content();
+	error_if(off >= buf.size());
+	cstring s;
+	buf.get(off, s);
+	return s;
+}
+
+/**
+ * Read an unsigned integer attribute of a DWARF-5 entry.
+ * @param c		Cursor on the entry.
+ * @param sm	Current state machine.
+ * @param form	Form of the attribute.
+ * @return		Read integer.
+ */
+t::uint64 DebugLine::readUData(Cursor& c, StateMachine& sm, t::uint64 form) {
+	switch(form) {
+	case DW_FORM_data1:	{ t::uint8 v; error_if(!c.read(v)); return v; }
+	case DW_FORM_data2:	{ t::uint16 v; error_if(!c.read(v)); return v; }
+	case DW_FORM_data4:	{ t::uint32 v; error_if(!c.read(v)); return v; }
+	case DW_FORM_data8:	{ t::uint64 v; error_if(!c.read(v)); return v; }
+	case DW_FORM_udata:	return readLEB128U(c);
+	default:			skipForm(c, sm, form); return 0;
+	}
+}
+
+/**
+ * Skip an attribute of a DWARF-5 entry.
+ * @param c		Cursor on the entry.
+ * @param sm	Current state machine.
+ * @param form	Form of the attribute.
+ */
+void DebugLine::skipForm(Cursor& c, StateMachine& sm, t::uint64 form) {
+	size_t size;
+	switch(form) {
+	case DW_FORM_flag_present: case DW_FORM_implicit_const:
+		size = 0; break;
+	case DW_FORM_data1: case DW_FORM_flag: case DW_FORM_strx1: case DW_FORM_ref1: case DW_FORM_addrx1:
+		size = 1; break;
+	case DW_FORM_data2: case DW_FORM_strx2: case DW_FORM_ref2: case DW_FORM_addrx2:
+		size = 2; break;
+	case DW_FORM_strx3: case DW_FORM_addrx3:
+		size = 3; break;
+	case DW_FORM_data4: case DW_FORM_strx4: case DW_FORM_ref4: case DW_FORM_addrx4: case DW_FORM_ref_sup4:
+		size = 4; break;
+	case DW_FORM_data8: case DW_FORM_ref8: case DW_FORM_ref_sig8: case DW_FORM_ref_sup8:
+		size = 8; break;
+	case DW_FORM_data16:
+		size = 16; break;
+	case DW_FORM_addr:
+		size = sm.address_size; break;
+	case DW_FORM_udata: case DW_FORM_sdata: case DW_FORM_strx: case DW_FORM_ref_udata:
+	case DW_FORM_addrx: case DW_FORM_loclistx: case DW_FORM_rnglistx:
+		size = 0; readLEB128U(c); break;
+	case DW_FORM_ref_addr:
+		if(sm.version <= 2)
+			size = sm.address_size;
+		else {
+			size = 0;
+			readOffset(c, sm);
+		}
+		break;
+	case DW_FORM_strp: case DW_FORM_line_strp: case DW_FORM_sec_offset: case DW_FORM_strp_sup:
+		size = 0; readOffset(c, sm); break;
+	case DW_FORM_indirect:
+		skipForm(c, sm, readLEB128U(c));
+		return;
+	case DW_FORM_string: {
+			cstring s;
+			size = 0;
+			error_if(!c.read(s));
+		}
+		break;
+	case DW_FORM_block: case DW_FORM_exprloc:
+		size = readLEB128U(c); break;
+	case DW_FORM_block1: {
+			t::uint8 l;
+			error_if(!c.read(l));
+			size = l;
+		}
+		break;
+	case DW_FORM_block2: {
+			t::uint16 l;
+			error_if(!c.read(l));
+			size = l;
+		}
+		break;
+	case DW_FORM_block4: {
+			t::uint32 l;
+			error_if(!c.read(l));
+			size = l;
+		}
+		break;
+	default:
+		throw gel::Exception(_ << "unsupported debug line form " << form);
+	}
+	error_if(!c.skip(size));
+}
+
+/**
+ * Add a file to the current compilation unit according to the mode of
+ * the state machine.
+ * @param e			Description of the file.
+ * @param sm		Current state machine.
+ * @param cu		Current compilation unit.
+ * @param define	True if the file comes from the DW_LNE_define_file opcode.
+ */
+void DebugLine::addFile(const FileEntry& e, StateMachine& sm, CompilationUnit *cu, bool define) {
+	int index = sm.file_count++;
+	if(sm.visitor != nullptr) {
+		cu->add(new File(sys::Path(e.dir) / e.name, e.date, e.size));
+		return;
+	}
+	if(!define) {
+		if(sm.collect != nullptr) {
+			sm.collect->add(e);
+			return;
+		}
+		if(!sm.record_files)
+			return;
+	}
+	else if(sm.loading) {
+		if(index >= cu->files().count())
+			static_cast<Unit *>(cu)->own(new File(sys::Path(e.dir) / e.name, e.date, e.size));
+		return;
+	}
+	cu->add(intern(e));
+}
+
+/**
+ * Get the source file corresponding to the given entry, creating it if
+ * needed. Files whose directory and name come from .debug_line_str are
+ * interned by string offsets: this avoids building and hashing their path
+ * again in each compilation unit.
+ * @param e		Description of the file.
+ * @return		Corresponding file.
+ */
+DebugLine::File *DebugLine::intern(const FileEntry& e) {
+	if(e.key != 0) {
+		File *f = interned.get(e.key, nullptr);
+		if(f != nullptr)
+			return f;
+	}
+	sys::Path p = sys::Path(e.dir) / e.name;
+	DEBUG("p = " << p);
 	File *f = files().get(p, nullptr);
 	if(f == nullptr) {
-		f = new File(p, date, size);
+		f = new File(p, e.date, e.size);
 		add(f);
 	}
-	cu->add(f);
-	return true;
+	if(e.key != 0)
+		interned.put(e.key, f);
+	return f;
 }
 
-size_t DebugLine::readHeaderLength(Cursor& c) {
-	if(!is_64) {
+size_t DebugLine::readOffset(Cursor& c, StateMachine& sm) {
+	if(!sm.is_64) {
 		t::uint32 l;
-		c.read(l);
-		static_cast<elf::File&>(prog).fix(l);
+		error_if(!c.read(l));
 		return l;
 	}
 	else {
 		t::uint64 l;
-		c.read(l);
-		static_cast<elf::File&>(prog).fix(l);
+		error_if(!c.read(l));
 		return l;
 	}
 }
 
-size_t DebugLine::readUnitLength(Cursor& c) {
+size_t DebugLine::readUnitLength(Cursor& c, StateMachine& sm) {
 	t::uint32 l;
 	error_if(!c.read(l));
 	if(l < 0xffffff00) {
-		static_cast<elf::File&>(prog).fix(l);
-		is_64 = false;
+		sm.is_64 = false;
 		return l;
 	}
 	t::uint64 ll;
 	error_if(!c.read(ll));
-	is_64 = true;
-	static_cast<elf::File&>(prog).fix(ll);
+	sm.is_64 = true;
 	return ll;
 }
 
@@ -441,17 +1181,25 @@ t::uint64 DebugLine::readLEB128U(Cursor& c) {
 	return r;
 }
 
-address_t DebugLine::readAddress(Cursor& c) {
-	if(!is_64) {
+address_t DebugLine::readAddress(Cursor& c, int size) {
+	if(size == 4) {
 		t::uint32 a;
 		error_if(!c.read(a));
-		static_cast<elf::File&>(prog).fix(a);
 		return a;
 	}
-	else {
+	else if(size == 8) {
 		t::uint64 a;
 		error_if(!c.read(a));
-		static_cast<elf::File&>(prog).fix(a);
+		return a;
+	}
+	else if(size == 2) {
+		t::uint16 a;
+		error_if(!c.read(a));
+		return a;
+	}
+	else {
+		t::uint8 a;
+		error_if(size != 1 || !c.read(a));
 		return a;
 	}
 }
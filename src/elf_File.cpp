@@ -17,12 +17,23 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <string.h>
 #include <elm/array.h>
 #include <gel++/elf/defs.h>
 #include <gel++/elf/File.h>
+#include <gel++/elf/FlatSymbolTable.h>
 #include <gel++/elf/UnixBuilder.h>
 #include <gel++/elf/DebugLine.h>
 #include <gel++/Image.h>
+#include <gel++/SymbolIndex.h>
+
+#ifndef _WIN32
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
 
 namespace gel { namespace elf {
 
@@ -60,6 +71,20 @@ private:
 /**
  * @class File
  * Class handling executable file in ELF format (32-bits).
+ *
+ * @par Concurrency
+ * Once opened (and mapped, if required), a File can be shared by several
+ * reader threads. The lazily-built parts (sections, program headers,
+ * segments, symbol tables, symbol index, hash section, debug lines and
+ * section or program header contents) are initialized exactly once, the
+ * first caller doing the work while the concurrent callers wait; afterwards
+ * they are accessed without locking. If an initialization throws an
+ * exception, the next call tries again: the failed initialization leaves
+ * the file unchanged and does not leak. The buffers and objects returned
+ * by a File must be considered as read-only by the sharing threads and
+ * the functions changing the File (@ref map() for instance) must not be
+ * called concurrently with other accesses.
+ *
  * @ingroup elf
  */
 
@@ -79,6 +104,28 @@ void File::unfix(t::uint64& i)	{ i = UN_ENDIAN8(id[EI_DATA], i); }
 void File::unfix(t::int64& i)	{ i = UN_ENDIAN8(id[EI_DATA], i); }
 
 
+/**
+ * @class Reader
+ * Decoding core of the ELF files parameterized by the ELF class (@ref Class32
+ * or @ref Class64) and the byte order (@ref LittleOrder or @ref BigOrder).
+ * Its functions are static and inlined: when the byte order matches the host,
+ * they are reduced to nothing. The four instances are named @ref Reader32L,
+ * @ref Reader32B, @ref Reader64L and @ref Reader64B.
+ *
+ * The byte order is selected once by the file per bulk operation (header,
+ * section table, program header table, symbol table) instead of being
+ * checked at each field access through the @ref Decoder interface.
+ * @ingroup elf
+ */
+
+/**
+ * @class Order
+ * Byte order used by @ref Reader: the parameter is either ELFDATA2LSB
+ * or ELFDATA2MSB.
+ * @ingroup elf
+ */
+
+
 /**
  * Test if the given magic number matches ELF.
  * param magic	Magic number to be tested.
@@ -93,36 +140,141 @@ bool File::matches(t::uint8 magic[4]) {
 
 
 /**
- * Constructor.
+ * Compute the generic file type from the ELF file type.
+ * @param elf_type	ELF file type (e_type).
+ * @return			Generic file type.
+ */
+File::type_t File::typeOf(int elf_type) {
+	switch(elf_type) {
+	case ET_NONE:
+	case ET_REL:	return no_type;
+	case ET_EXEC:	return program;
+	case ET_DYN:	return library;
+	case ET_CORE:	return program;
+	default:		return no_type;
+	}
+}
+
+
+/**
+ * Constructor. The file is read either from the given stream, or, if the
+ * stream is null, from the given file descriptor opened on path. In both
+ * cases, the file takes the ownership of the stream or of the descriptor.
+ * Reading from a descriptor allows concurrent positional reads and
+ * memory mapping.
  * @param manager	Parent manager.
  * @param path		File path.
- * @param stream	Stream to read from.
+ * @param stream	Stream to read from (null to use fd).
+ * @param fd		File descriptor to read from if stream is null.
  */
-File::File(Manager& manager, sys::Path path, io::RandomAccessStream *stream)
+File::File(Manager& manager, sys::Path path, io::RandomAccessStream *stream, int fd)
 :	gel::File(manager, path),
 	s(stream),
+	fd(stream == nullptr ? fd : -1),
+	map_buf(nullptr),
+	map_size(0),
 	id(nullptr),
-	ph_loaded(false),
-	sects_loaded(false),
 	str_tab(nullptr),
-	syms(nullptr),
-	segs_init(false),
+	sym_tab(nullptr),
+	flat_syms(nullptr),
+	hash_sect(nullptr),
 	debug(nullptr)
 {
+	ASSERTP(s != nullptr || this->fd >= 0, "ELF file without stream nor descriptor");
 }
 
 /**
  */
 File::~File(void) {
 	delete s;
-	if(syms != nullptr)
-		delete syms;
+	if(sym_tab != nullptr)
+		delete sym_tab;
+	if(flat_syms != nullptr)
+		delete flat_syms;
 	for(auto s: sects)
 		delete s;
 	for(auto p: phs)
 		delete p;
 	for(auto s: segs)
 		delete s;
+	unmap();
+#	ifndef _WIN32
+		if(fd >= 0)
+			::close(fd);
+#	endif
+}
+
+
+/**
+ * Map the file in memory (read-only). Once mapped, the section and program
+ * header contents are no more copied from the file but points directly
+ * in the mapping: only the pages actually accessed are loaded by the OS.
+ * This function is usually called by the @ref Manager when
+ * @ref Manager::MAP_FILES is set.
+ *
+ * As the mapping is read-only, the buffers returned by Section::content()
+ * must not be written. Writable program headers and program headers
+ * with a zero-filled part are still copied.
+ *
+ * Only files read from their own descriptor (as opened by
+ * Manager::openELFFile(sys::Path)) can be mapped: a file read from a
+ * caller stream is never mapped.
+ *
+ * @return	True if the file is mapped, false if the mapping is not
+ * 			supported or failed (the file is then read as usual).
+ */
+bool File::map() {
+#	ifdef _WIN32
+		return false;
+#	else
+		if(map_buf != nullptr)
+			return true;
+		if(fd < 0)
+			return false;
+		struct stat st;
+		void *m = MAP_FAILED;
+		if(fstat(fd, &st) >= 0 && st.st_size > 0)
+			m = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(m == MAP_FAILED)
+			return false;
+		map_buf = static_cast<t::uint8 *>(m);
+		map_size = st.st_size;
+		return true;
+#	endif
+}
+
+
+/**
+ * @fn bool File::isMapped() const;
+ * Test if the file is memory-mapped.
+ * @return	True if the file is mapped, false else.
+ */
+
+
+/**
+ * Release the file mapping, if any.
+ */
+void File::unmap() {
+#	ifndef _WIN32
+		if(map_buf != nullptr)
+			munmap(map_buf, map_size);
+#	endif
+	map_buf = nullptr;
+	map_size = 0;
+}
+
+
+/**
+ * Get a pointer inside the file mapping.
+ * @param offset	Offset in the file.
+ * @param size		Size of the looked block.
+ * @return			Pointer to the block in the mapping or null if the
+ * 					file is not mapped or the block is out of the file.
+ */
+t::uint8 *File::mapAt(offset_t offset, size_t size) {
+	if(map_buf == nullptr || offset > map_size || size > map_size - offset)
+		return nullptr;
+	return map_buf + offset;
 }
 
 /**
@@ -130,15 +282,205 @@ File::~File(void) {
  * @return	Map of symbols.
  */
 const gel::SymbolTable& File::symbols() {
-	if(syms == nullptr) {
-		syms = new SymbolTable();
+	std::call_once(sym_once, [this]() {
 		initSections();
-		for(auto s: sects) {
-			if(s->type() == SHT_SYMTAB || s->type() == SHT_DYNSYM)
-				fillSymbolTable(*syms, s);
+		auto t = new SymbolTable();
+		try {
+			for(auto s: sects) {
+				if(s->type() == SHT_SYMTAB || s->type() == SHT_DYNSYM)
+					fillSymbolTable(*t, s);
+			}
 		}
+		catch(gel::Exception& e) {
+			delete t;
+			throw;
+		}
+		sym_tab = t;
+	});
+	return *sym_tab;
+}
+
+/**
+ * Build the symbol index from the static symbol table (SHT_SYMTAB) or, if
+ * the file is stripped, from the dynamic symbol table (SHT_DYNSYM). Unlike
+ * the name-keyed @ref symbols(), all symbols are considered, including
+ * same-named static symbols of different compilation units.
+ * @return	Built symbol index.
+ * @throw gel::Exception	If the symbol table cannot be read.
+ */
+SymbolIndex *File::makeSymbolIndex() {
+	symbols();
+	const auto& syms = sym_tab->all(false);
+	return new SymbolIndex(syms.count() != 0 ? syms : sym_tab->all(true));
+}
+
+/**
+ * Get the compact symbol table of the file. Unlike @ref symbols(), the
+ * symbols are not stored as individual objects but in flat arrays:
+ * this is the preferred way to access symbols of big executables.
+ * @return	Flat symbol table.
+ * @throw gel::Exception	If the symbol table cannot be read.
+ */
+const FlatSymbolTable& File::flatSymbols() {
+	std::call_once(flat_once, [this]() {
+		initSections();
+		flat_syms = new FlatSymbolTable(*this);
+	});
+	return *flat_syms;
+}
+
+/**
+ * Look for a dynamic symbol by its name using the hash section of the file
+ * (SHT_GNU_HASH is preferred to SHT_HASH when both are available). Only
+ * the hashed dynamic symbol table is visited and no symbol object is built:
+ * this is the fast way to test if a library exports a symbol. Undefined
+ * symbols are ignored.
+ * @param name	Name of the looked symbol.
+ * @param sym	Filled with the symbol description if found.
+ * @return		True if the symbol is found, false if it is not found or
+ * 				if the file has no hash section.
+ * @throw gel::Exception	If the hash section cannot be read.
+ */
+bool File::findDynamic(cstring name, sym_t& sym) {
+	std::call_once(hash_once, [this]() {
+		initSections();
+		for(auto s: sects)
+			if(s->type() == SHT_GNU_HASH
+			|| (s->type() == SHT_HASH && hash_sect == nullptr))
+				hash_sect = s;
+	});
+	if(hash_sect == nullptr)
+		return false;
+	else if(hash_sect->type() == SHT_GNU_HASH)
+		return lookupGNUHash(name, sym);
+	else
+		return lookupHash(name, sym);
+}
+
+/**
+ * Test if the symbol at the given index of the dynamic symbol table
+ * has the given name and, if so, decode it.
+ * @param dynsym	Dynamic symbol table.
+ * @param i			Index of the symbol.
+ * @param name		Looked name.
+ * @param sym		Filled with the symbol description if it matches.
+ * @return			True if it matches, false else.
+ */
+bool File::matchDynamic(Section *dynsym, t::uint32 i, cstring name, sym_t& sym) {
+	if(dynsym->entsize() == 0 || i >= dynsym->size() / dynsym->entsize())
+		return false;
+	fetchSym(dynsym->content().bytes() + i * dynsym->entsize(), sym);
+	if(sym.shndx == SHN_UNDEF || dynsym->link() >= t::uint32(sects.count()))
+		return false;
+	Buffer str = sects[dynsym->link()]->content();
+	if(sym.name >= str.size())
+		return false;
+	return strcmp(reinterpret_cast<const char *>(str.bytes()) + sym.name, name.chars()) == 0;
+}
+
+/**
+ * Look a dynamic symbol using a SHT_HASH section.
+ * @param name	Looked name.
+ * @param sym	Filled with the symbol description if found.
+ * @return		True if found, false else.
+ */
+bool File::lookupHash(cstring name, sym_t& sym) {
+	if(hash_sect->link() >= t::uint32(sects.count()))
+		return false;
+	Section *dynsym = sects[hash_sect->link()];
+	Buffer buf = hash_sect->content();
+	if(buf.size() < 2 * sizeof(t::uint32))
+		return false;
+
+	// read the header
+	t::uint32 nbucket, nchain;
+	buf.get(0, nbucket);
+	buf.get(4, nchain);
+	if(nbucket == 0 || (2 + t::uint64(nbucket) + nchain) * sizeof(t::uint32) > buf.size())
+		return false;
+
+	// compute the hash
+	t::uint32 h = 0;
+	for(const char *p = name.chars(); *p != '\0'; p++) {
+		h = (h << 4) + t::uint8(*p);
+		t::uint32 g = h & 0xf0000000;
+		if(g != 0)
+			h ^= g >> 24;
+		h &= ~g;
 	}
-	return *syms;
+
+	// traverse the chain (bounded by nchain to resist to cycles)
+	t::uint32 i;
+	buf.get((2 + h % nbucket) * sizeof(t::uint32), i);
+	for(t::uint32 n = 0; i != STN_UNDEF && i < nchain && n < nchain; n++) {
+		if(matchDynamic(dynsym, i, name, sym))
+			return true;
+		buf.get((2 + nbucket + i) * sizeof(t::uint32), i);
+	}
+	return false;
+}
+
+/**
+ * Look a dynamic symbol using a SHT_GNU_HASH section. The bloom filter
+ * of the section is used to answer quickly when the symbol is not defined.
+ * @param name	Looked name.
+ * @param sym	Filled with the symbol description if found.
+ * @return		True if found, false else.
+ */
+bool File::lookupGNUHash(cstring name, sym_t& sym) {
+	if(hash_sect->link() >= t::uint32(sects.count()))
+		return false;
+	Section *dynsym = sects[hash_sect->link()];
+	Buffer buf = hash_sect->content();
+	if(buf.size() < 4 * sizeof(t::uint32))
+		return false;
+
+	// read the header
+	t::uint32 nbuckets, symoffset, bloom_size, bloom_shift;
+	buf.get(0, nbuckets);
+	buf.get(4, symoffset);
+	buf.get(8, bloom_size);
+	buf.get(12, bloom_shift);
+	int wsize = ident()[EI_CLASS] == ELFCLASS64 ? 8 : 4;
+	t::uint64 buckets = 16 + t::uint64(bloom_size) * wsize;
+	t::uint64 chains = buckets + t::uint64(nbuckets) * sizeof(t::uint32);
+	if(nbuckets == 0 || bloom_size == 0 || chains > buf.size())
+		return false;
+
+	// compute the hash
+	t::uint32 h = 5381;
+	for(const char *p = name.chars(); *p != '\0'; p++)
+		h = h * 33 + t::uint8(*p);
+
+	// check the bloom filter
+	t::uint32 bits = wsize * 8;
+	t::uint64 mask = (t::uint64(1) << (h % bits)) | (t::uint64(1) << ((h >> bloom_shift) % bits));
+	t::uint64 word;
+	offset_t off = 16 + ((h / bits) % bloom_size) * wsize;
+	if(wsize == 8)
+		buf.get(off, word);
+	else {
+		t::uint32 w;
+		buf.get(off, w);
+		word = w;
+	}
+	if((word & mask) != mask)
+		return false;
+
+	// traverse the chain
+	t::uint32 i;
+	buf.get(buckets + (h % nbuckets) * sizeof(t::uint32), i);
+	if(i < symoffset)
+		return false;
+	for(offset_t o = chains + (i - symoffset) * sizeof(t::uint32); o + sizeof(t::uint32) <= buf.size(); o += sizeof(t::uint32), i++) {
+		t::uint32 h2;
+		buf.get(o, h2);
+		if((h | 1) == (h2 | 1) && matchDynamic(dynsym, i, name, sym))
+			return true;
+		if((h2 & 1) != 0)
+			break;
+	}
+	return false;
 }
 
 /**
@@ -147,10 +489,7 @@ const gel::SymbolTable& File::symbols() {
  * @throw gel::Exception	If there is a file read error.
  */
 Vector<ProgramHeader *>& File::programHeaders(void) {
-	if(!ph_loaded) {
-		loadProgramHeaders(phs);
-		ph_loaded = true;
-	}
+	std::call_once(ph_once, [this]() { loadProgramHeaders(phs); });
 	return phs;
 }
 
@@ -182,23 +521,61 @@ cstring File::stringAt(t::uint64 offset, int sect) {
 
 
 /**
- * Read from the file and throw an exception if there is an error.
+ * Read from the current position of the stream and throw an exception
+ * if there is an error. The caller must hold the stream lock.
  * @param buf	Buffer to fill in.
  * @param size	Size of the buffer.
  */
-void File::read(void *buf, t::uint32 size) {
-	if(t::uint32(s->read(buf, size)) != size)
-		throw Exception(_ << "cannot read " << size << " bytes from " << path() << ": " << s->io::InStream::lastErrorMessage());
+void File::read(void *buf, size_t size) {
+	t::uint8 *p = static_cast<t::uint8 *>(buf);
+	while(size != 0) {
+		int n = size > 0x40000000 ? 0x40000000 : int(size);
+		if(s->read(p, n) != n)
+			throw Exception(_ << "cannot read " << size << " bytes from " << path() << ": " << s->io::InStream::lastErrorMessage());
+		p += n;
+		size -= n;
+	}
 }
 
 
 /**
- * Read a lock at a particular position.
+ * Read a block at a particular position. Offset and size are 64-bit wide.
+ * When the file is not mapped, the block is read with positional reads
+ * (pread) on the descriptor of the file that do not use a shared file
+ * position: this function can be called concurrently from several threads.
+ * If the file is read from a stream, the stream is used under a lock.
  * @param pos	Position in file.
  * @param buf	Buffer to fill in.
  * @param size	Size of the buffer.
+ * @throw gel::Exception	If the block cannot be read.
  */
-void File::readAt(t::uint32 pos, void *buf, t::uint32 size) {
+void File::readAt(offset_t pos, void *buf, size_t size) {
+	if(map_buf != nullptr) {
+		const t::uint8 *p = mapAt(pos, size);
+		if(p == nullptr)
+			throw Exception(_ << "cannot read " << size << " bytes at " << pos << " from " << path() << ": out of file");
+		array::copy(static_cast<t::uint8 *>(buf), p, size);
+		return;
+	}
+#	ifndef _WIN32
+		if(fd >= 0) {
+			t::uint8 *p = static_cast<t::uint8 *>(buf);
+			while(size != 0) {
+				ssize_t r = ::pread(fd, p, size, pos);
+				if(r < 0 && errno == EINTR)
+					continue;
+				else if(r < 0)
+					throw Exception(_ << "cannot read " << size << " bytes at " << pos << " from " << path() << ": " << strerror(errno));
+				else if(r == 0)
+					throw Exception(_ << "cannot read " << size << " bytes at " << pos << " from " << path() << ": out of file");
+				p += r;
+				pos += r;
+				size -= r;
+			}
+			return;
+		}
+#	endif
+	std::lock_guard<std::mutex> guard(s_lock);
 	if(!s->moveTo(pos))
 		throw Exception(_ << "cannot move to position " << pos << " in " << path() << ": " << s->io::InStream::lastErrorMessage());
 	read(buf, size);
@@ -231,12 +608,11 @@ Image *File::make(const Parameter& params) {
 
 ///
 void File::initSegments() {
-	if(segs_init)
-		return;
-	for(auto ph: programHeaders())
-		if(ph->type() == PT_LOAD)
-			segs.add(new Segment(ph));
-	segs_init = true;
+	std::call_once(segs_once, [this]() {
+		for(auto ph: programHeaders())
+			if(ph->type() == PT_LOAD)
+				segs.add(new Segment(ph));
+	});
 }
 
 
@@ -361,8 +737,7 @@ string File::os() const {
 
 ///
 gel::DebugLine *File::debugLines() {
-	if(debug == nullptr)
-		debug = new DebugLine(this);
+	std::call_once(debug_once, [this]() { debug = new DebugLine(this); });
 	return debug;
 }
 
@@ -371,10 +746,7 @@ gel::DebugLine *File::debugLines() {
  * Initialize the section part.
  */
 void File::initSections(void) {
-	if(!sects_loaded) {
-		loadSections(sects);
-		sects_loaded = true;
-	}
+	std::call_once(sects_once, [this]() { loadSections(sects); });
 }
 
 
@@ -413,22 +785,37 @@ Section *File::findSection(cstring name) {
  * @param file	Parent file.
  * @param entry	Section entry.
  */
-Section::Section(elf::File *file): _file(file), buf(0) {
+Section::Section(elf::File *file): _file(file), buf(0), mapped(false) {
 }
 
 Section::~Section(void) {
-	if(buf)
+	if(buf && !mapped)
 		delete [] buf;
 }
 
 /**
- * Get the content of the section (if any).
+ * Get the content of the section (if any). The content is the raw content
+ * of the file: for sections containing structured data (symbols, dynamic
+ * entries, etc), the decoder of the buffer has to be used to fix the
+ * endianness of the fields.
+ *
+ * If the file is mapped, the buffer points directly inside the mapping
+ * and must not be modified.
+ *
  * @return	Section content.
  * @throw gel::Exception	If there is a file read error.
  */
 Buffer Section::content() {
-	if(!buf)
-		buf = readBuf();
+	std::call_once(once, [this]() {
+		t::uint8 *b = nullptr;
+		if(type() != SHT_NOBITS)
+			b = _file->mapAt(offset(), size());
+		if(b != nullptr)
+			mapped = true;
+		else
+			b = readBuf();
+		buf = b;
+	});
 	return Buffer(_file, buf, size());
 }
 
@@ -442,24 +829,41 @@ Buffer Section::content() {
 
 /**
  */
-ProgramHeader::ProgramHeader(elf::File *file): _file(file), _buf(nullptr) {
+ProgramHeader::ProgramHeader(elf::File *file): _file(file), _buf(nullptr), _size(0), _mapped(false) {
 }
 
 /**
  */
 ProgramHeader::~ProgramHeader(void) {
-	if(_buf)
-		delete [] _buf;
+	if(_buf && !_mapped)
+		freeZeroed(_buf, _size);
 }
 
 /**
  * Get the content of the program header.
+ *
+ * If the file is mapped and the program header is not writable and
+ * is fully contained in the file, the buffer points directly inside
+ * the mapping and must not be modified. Else the zero-filled part
+ * (when the memory size is bigger than the file size) is allocated
+ * lazily by the OS as it is first written.
+ *
  * @return	Program header contant.
  * @throw gel::Exception	If there is an error at file read.
  */
 Buffer ProgramHeader::content(void) {
-	if(_buf == nullptr)
-		_buf = readBuf();
+	std::call_once(_once, [this]() {
+		t::uint8 *b = nullptr;
+		if((flags() & PF_W) == 0 && filesz() == memsz())
+			b = _file->mapAt(offset(), filesz());
+		if(b != nullptr)
+			_mapped = true;
+		else {
+			_size = memsz();
+			b = readBuf();
+		}
+		_buf = b;
+	});
 	return Buffer(_file, _buf, memsz());
 }
 
@@ -507,6 +911,10 @@ cstring Symbol::name() {
 
 ///
 SymbolTable::~SymbolTable() {
+	for(auto s: ssyms)
+		delete s;
+	for(auto s: dsyms)
+		delete s;
 	for(auto m: mems)
 		delete [] m;
 }
@@ -517,6 +925,29 @@ void SymbolTable::record(elm::t::uint8 *mem) {
 	mems.add(mem);
 }
 
+/**
+ * Add a symbol to the table. The table takes ownership of the symbol and
+ * keeps it even if a symbol of the same name hides it in the map.
+ * @param sym		Added symbol.
+ * @param dynamic	True if the symbol comes from SHT_DYNSYM, false
+ * 					if it comes from SHT_SYMTAB.
+ */
+void SymbolTable::add(Symbol *sym, bool dynamic) {
+	put(sym->name(), sym);
+	if(dynamic)
+		dsyms.add(sym);
+	else
+		ssyms.add(sym);
+}
+
+/**
+ * @fn const Vector<gel::Symbol *>& SymbolTable::all(bool dynamic) const;
+ * Get all symbols of the static or of the dynamic symbol table, in the
+ * order of the file, including same-named symbols.
+ * @param dynamic	True for SHT_DYNSYM, false for SHT_SYMTAB.
+ * @return			Symbols of the table.
+ */
+
 
 /**
  * @class  NoteIter
@@ -601,9 +1032,7 @@ void NoteIter::next(void) {
 
 ///
 File::DynIter::DynIter(File& file, Section *sec, bool ended): EntryIter(file, sec, ended) {
-	if(ended)
-		c.finish();
-	else if(!c.ended())
+	if(!EntryIter::ended())
 		f.fetchDyn(c.here(), d);
 }
 
@@ -619,4 +1048,42 @@ Range<File::DynIter> File::dyns(Section *sect) {
 	return range(DynIter(*this, sect), DynIter(*this, sect, true));
 }
 
+
+/**
+ * @class SymIter
+ * Iterator on the symbols of a symbol section (SHT_SYMTAB or SHT_DYNSYM).
+ * The entries are decoded on the fly in a @ref File::sym_t: no symbol
+ * object is allocated and no table is built. This is the cheapest way
+ * to scan all symbols once.
+ */
+
+///
+File::SymIter::SymIter(File& file, Section *sec, bool ended): EntryIter(file, sec, ended) {
+	if(sec->link() < t::uint32(file.sections().count()))
+		str = file.sections()[sec->link()]->content();
+	if(!EntryIter::ended())
+		f.fetchSym(c.here(), sym);
+}
+
+/**
+ * Get the name of the current symbol.
+ * @return	Symbol name (empty string if the name is out of the string table
+ * 			or not terminated inside it).
+ */
+cstring File::SymIter::name() const {
+	if(sym.name >= str.size()
+	|| memchr(str.bytes() + sym.name, '\0', str.size() - sym.name) == nullptr)
+		return "";
+	return cstring(reinterpret_cast<const char *>(str.bytes()) + sym.name);
+}
+
+/**
+ * Get a range to iterate on the symbols of the given section.
+ * @param sect	Symbol section (SHT_SYMTAB or SHT_DYNSYM).
+ * @return		Range on the symbols.
+ */
+Range<File::SymIter> File::syms(Section *sect) {
+	return range(SymIter(*this, sect), SymIter(*this, sect, true));
+}
+
 } }	// gel::elf
@@ -20,6 +20,7 @@
 #include <elm/array.h>
 #include <gel++/elf/defs.h>
 #include <gel++/elf/File32.h>
+#include <gel++/elf/Reader.h>
 #include <gel++/elf/UnixBuilder.h>
 #include <gel++/Image.h>
 
@@ -36,10 +37,11 @@ namespace gel { namespace elf {
  * Constructor.
  * @param manager	Parent manager.
  * @param path		File path.
- * @param stream	Stream to read from.
+ * @param stream	Stream to read from (null to use fd).
+ * @param fd		File descriptor to read from if stream is null.
  */
-File32::File32(Manager& manager, sys::Path path, io::RandomAccessStream *stream)
-:	elf::File(manager, path, stream),
+File32::File32(Manager& manager, sys::Path path, io::RandomAccessStream *stream, int fd)
+:	elf::File(manager, path, stream, fd),
 	h(new Elf32_Ehdr),
 	sec_buf(nullptr),
 	ph_buf(nullptr)
@@ -52,19 +54,12 @@ File32::File32(Manager& manager, sys::Path path, io::RandomAccessStream *stream)
 	|| h->e_ident[3] != ELFMAG3)
 		throw Exception("not an ELF file");
 	ASSERT(h->e_ident[EI_CLASS] == ELFCLASS32);
-	fix(h->e_type);
-	fix(h->e_machine);
-	fix(h->e_version);
-	fix(h->e_entry);
-	fix(h->e_shnum);
-	fix(h->e_phnum);
-	fix(h->e_shentsize);
-	fix(h->e_phentsize);
-	fix(h->e_shstrndx);
+	if(isBigEndian())
+		Reader32B::fix(*h);
+	else
+		Reader32L::fix(*h);
 	if(h->e_shstrndx >= h->e_shnum)
 		throw Exception("malformed ELF");
-	fix(h->e_shoff);
-	fix(h->e_phoff);
 }
 
 /**
@@ -82,24 +77,25 @@ File32::~File32(void) {
 void File32::loadProgramHeaders(Vector<ProgramHeader *>& headers) {
 	if(ph_buf == nullptr) {
 
-		// load it
-		ph_buf = new t::uint8[h->e_phentsize * h->e_phnum];
-		readAt(h->e_phoff, ph_buf, h->e_phentsize * h->e_phnum);
+		// load it (keeping the file unchanged in case of error)
+		t::uint8 *buf = new t::uint8[h->e_phentsize * h->e_phnum];
+		try {
+			readAt(h->e_phoff, buf, h->e_phentsize * h->e_phnum);
+		}
+		catch(gel::Exception& e) {
+			delete [] buf;
+			throw;
+		}
+		ph_buf = buf;
 
 		// build them
+		if(isBigEndian())
+			Reader32B::fixProgramHeaders(ph_buf, h->e_phnum, h->e_phentsize);
+		else
+			Reader32L::fixProgramHeaders(ph_buf, h->e_phnum, h->e_phentsize);
 		headers.setLength(h->e_phnum);
-		for(int i = 0; i < h->e_phnum; i++) {
-			Elf32_Phdr *ph = (Elf32_Phdr *)(ph_buf + i * h->e_phentsize);
-			fix(ph->p_align);
-			fix(ph->p_filesz);
-			fix(ph->p_flags);
-			fix(ph->p_memsz);
-			fix(ph->p_offset);
-			fix(ph->p_paddr);
-			fix(ph->p_type);
-			fix(ph->p_vaddr);
-			headers[i] = new ProgramHeader32(this, ph);
-		}
+		for(int i = 0; i < h->e_phnum; i++)
+			headers[i] = new ProgramHeader32(this, (Elf32_Phdr *)(ph_buf + i * h->e_phentsize));
 	}
 }
 
@@ -137,14 +133,7 @@ const t::uint8 *File32::ident() {
 /**
  */
 File::type_t File32::type(void) {
-	switch(h->e_type) {
-	case ET_NONE:
-	case ET_REL:	return no_type;
-	case ET_EXEC:	return program;
-	case ET_DYN:	return library;
-	case ET_CORE:	return program;
-	default:		return no_type;
-	}
+	return typeOf(h->e_type);
 }
 
 
@@ -165,30 +154,26 @@ address_t File32::entry(void) {
 ///
 void File32::loadSections(Vector<Section *>& sections) {
 
-	// allocate memory
+	// load sections (keeping the file unchanged in case of error)
 	t::uint32 size = h->e_shentsize * h->e_shnum;
-	sec_buf = new t::uint8[size];
-	array::set<uint8_t>(sec_buf, size, 0);
-
-	// load sections
-	readAt(h->e_shoff, sec_buf, size);
+	t::uint8 *buf = new t::uint8[size];
+	try {
+		readAt(h->e_shoff, buf, size);
+	}
+	catch(gel::Exception& e) {
+		delete [] buf;
+		throw;
+	}
+	sec_buf = buf;
 
 	// initialize sections
+	if(isBigEndian())
+		Reader32B::fixSections(sec_buf, h->e_shnum, h->e_shentsize);
+	else
+		Reader32L::fixSections(sec_buf, h->e_shnum, h->e_shentsize);
 	sections.setLength(h->e_shnum);
-	for(int i = 0; i < h->e_shnum; i++) {
-		Elf32_Shdr *s = (Elf32_Shdr *)(sec_buf + i * h->e_shentsize);
-		fix(s->sh_addr);
-		fix(s->sh_addralign);
-		fix(s->sh_entsize);
-		fix(s->sh_flags);
-		fix(s->sh_info);
-		fix(s->sh_link);
-		fix(s->sh_name);
-		fix(s->sh_offset);
-		fix(s->sh_size);
-		fix(s->sh_type);
-		sections[i] = new Section32(this, s);
-	}
+	for(int i = 0; i < h->e_shnum; i++)
+		sections[i] = new Section32(this, (Elf32_Shdr *)(sec_buf + i * h->e_shentsize));
 }
 
 ///
@@ -199,13 +184,31 @@ int File32::getStrTab() {
 ///
 void File32::fetchDyn(const t::uint8 *entry, dyn_t& dyn) {
 	auto e = *reinterpret_cast<const Elf32_Dyn *>(entry);
-	fix(e.d_tag);
-	fix(e.d_un.d_val);
+	if(isBigEndian())
+		Reader32B::fix(e);
+	else
+		Reader32L::fix(e);
 	dyn.tag = e.d_tag;
 	dyn.un.val = e.d_un.d_val;
 }
 
 
+///
+void File32::fetchSym(const t::uint8 *entry, sym_t& sym) {
+	auto s = *reinterpret_cast<const Elf32_Sym *>(entry);
+	if(isBigEndian())
+		Reader32B::fix(s);
+	else
+		Reader32L::fix(s);
+	sym.name = s.st_name;
+	sym.info = s.st_info;
+	sym.other = s.st_other;
+	sym.shndx = s.st_shndx;
+	sym.value = s.st_value;
+	sym.size = s.st_size;
+}
+
+
 ///
 class Symbol32: public Symbol {
 public:
@@ -254,16 +257,14 @@ void File32::fillSymbolTable(SymbolTable& symtab, Section *sect) {
 	auto entsize = sect->entsize();
 	if((size / entsize) * entsize != size)
 		throw Exception(_ << "garbage found at end of symbol table " << sect->name());
-	Cursor c(Buffer(this, buf, size));
-	while(c.avail(entsize)) {
-		Elf32_Sym *s = (Elf32_Sym *)c.here();
-		c.decoder()->fix(s->st_name);
-		c.decoder()->fix(s->st_value);
-		c.decoder()->fix(s->st_size);
-		c.decoder()->fix(s->st_shndx);
-		c.skip(entsize);
+	if(isBigEndian())
+		Reader32B::fixSymbols(buf, size, entsize);
+	else
+		Reader32L::fixSymbols(buf, size, entsize);
+	for(size_t o = 0; o + entsize <= size; o += entsize) {
+		Elf32_Sym *s = (Elf32_Sym *)(buf + o);
 		auto name = stringAt(s->st_name, str);
-		symtab.put(name, new Symbol32(name, s));
+		symtab.add(new Symbol32(name, s), sect->type() == SHT_DYNSYM);
 	}
 }
 
@@ -285,26 +286,14 @@ Section32::Section32(elf::File32 *file, Elf32_Shdr *entry): elf::Section(file),
 
 ///
 t::uint8 *Section32::readBuf() {
-
-	// read the data
 	t::uint8 *buf = new t::uint8[_info->sh_size];
-	readAt(_info->sh_offset, buf, _info->sh_size);
-
-	// fix endianness according to the section type
-	if(_info->sh_type == SHT_SYMTAB || _info->sh_type == SHT_DYNSYM) {
-		if((_info->sh_size / _info->sh_entsize) * _info->sh_entsize != _info->sh_size)
-			throw Exception(_ << "garbage found at end of symbol table " << name());
-		Cursor c(Buffer(file(), buf, _info->sh_size));
-		while(c.avail(_info->sh_entsize)) {
-			Elf32_Sym *s = (Elf32_Sym *)c.here();
-			c.decoder()->fix(s->st_name);
-			c.decoder()->fix(s->st_value);
-			c.decoder()->fix(s->st_size);
-			c.decoder()->fix(s->st_shndx);
-			c.skip(_info->sh_entsize);
-		}
+	try {
+		readAt(_info->sh_offset, buf, _info->sh_size);
+	}
+	catch(gel::Exception& e) {
+		delete [] buf;
+		throw;
 	}
-
 	return buf;
 }
 
@@ -393,11 +382,15 @@ offset_t 	ProgramHeader32::offset() const { return _info->p_offset; }
 
 ///
 t::uint8 *ProgramHeader32::readBuf() {
-	t::uint8 *_buf = new t::uint8[_info->p_memsz];
+	t::uint8 *_buf = allocZeroed(_info->p_memsz);
 	if(_info->p_filesz)
-		readAt(_info->p_offset, _buf, _info->p_filesz);
-	if(_info->p_filesz < _info->p_memsz)
-		array::set(_buf, _info->p_memsz - _info->p_filesz, t::uint8(0));
+		try {
+			readAt(_info->p_offset, _buf, _info->p_filesz);
+		}
+		catch(gel::Exception& e) {
+			freeZeroed(_buf, _info->p_memsz);
+			throw;
+		}
 	return _buf;
 }
 
@@ -0,0 +1,314 @@
+/*
+ * gel::elf::FlatSymbolTable class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <gel++/elf/defs.h>
+#include <gel++/elf/FlatSymbolTable.h>
+
+namespace gel { namespace elf {
+
+/**
+ * @class FlatSymbol
+ * Lightweight handle on a symbol of a @ref FlatSymbolTable. It is made
+ * only of a reference to the table and of the symbol index: it can be
+ * freely copied and is only valid as long as the table is alive.
+ * @ingroup elf
+ */
+
+/**
+ * @fn FlatSymbol::FlatSymbol();
+ * Build a null symbol handle.
+ */
+
+/**
+ * @fn bool FlatSymbol::isNull() const;
+ * Test if the symbol handle is null.
+ * @return	True if the handle is null, false else.
+ */
+
+/**
+ * @fn int FlatSymbol::index() const;
+ * Get the index of the symbol in its table.
+ * @return	Symbol index.
+ */
+
+/**
+ * Get the name of the symbol.
+ * @return	Symbol name.
+ */
+cstring FlatSymbol::name() const {
+	return _tab->nameOf(_i);
+}
+
+/**
+ * @fn t::uint64 FlatSymbol::value() const;
+ * Get the value of the symbol.
+ * @return	Symbol value (address for functions and data).
+ */
+
+/**
+ * @fn t::uint64 FlatSymbol::size() const;
+ * Get the size of the symbol.
+ * @return	Symbol size.
+ */
+
+/**
+ * @fn t::uint8 FlatSymbol::elfBind() const;
+ * Get the ELF binding of the symbol (one of STB_xxx).
+ * @return	ELF binding.
+ */
+
+/**
+ * @fn t::uint8 FlatSymbol::elfType() const;
+ * Get the ELF type of the symbol (one of STT_xxx).
+ * @return	ELF type.
+ */
+
+/**
+ * @fn int FlatSymbol::shndx() const;
+ * Get the index of the section the symbol is defined in.
+ * @return	Section index.
+ */
+
+/**
+ * Get the generic type of the symbol.
+ * @return	Symbol type.
+ */
+gel::Symbol::type_t FlatSymbol::type() const {
+	switch(elfType()) {
+	case STT_OBJECT:	return gel::Symbol::DATA;
+	case STT_FUNC:		return gel::Symbol::FUNC;
+	default:			return gel::Symbol::OTHER_TYPE;
+	}
+}
+
+/**
+ * Get the generic binding of the symbol.
+ * @return	Symbol binding.
+ */
+gel::Symbol::bind_t FlatSymbol::bind() const {
+	switch(elfBind()) {
+	case STB_LOCAL:		return gel::Symbol::LOCAL;
+	case STB_GLOBAL:	return gel::Symbol::GLOBAL;
+	case STB_WEAK:		return gel::Symbol::WEAK;
+	default:			return gel::Symbol::OTHER_BIND;
+	}
+}
+
+
+/**
+ * @class FlatSymbolTable
+ * Compact symbol table of an ELF file gathering the symbols of all
+ * SHT_SYMTAB and SHT_DYNSYM sections. The symbols are not stored as objects
+ * but as a structure of arrays (name offset, value, size, info and section
+ * index) allocated in one block: only 23 bytes are used per symbol.
+ * The symbols are accessed by index or by name using @ref FlatSymbol
+ * handles.
+ *
+ * Notice that a name lookup, @ref find(), sorts the symbols by name
+ * the first time it is called.
+ *
+ * @ingroup elf
+ */
+
+/**
+ * Build the flat symbol table for the given file.
+ * @param file				File to get symbols from.
+ * @throw gel::Exception	If there is a read error or a malformed symbol table.
+ */
+FlatSymbolTable::FlatSymbolTable(File& file)
+:	_file(file),
+	_count(0),
+	_arena(nullptr),
+	_value(nullptr),
+	_size(nullptr),
+	_name(nullptr),
+	_shndx(nullptr),
+	_info(nullptr),
+	_by_name(nullptr)
+{
+
+	// count the symbols
+	for(auto s: file.sections())
+		if((s->type() == SHT_SYMTAB || s->type() == SHT_DYNSYM) && s->entsize() != 0) {
+			if((s->size() / s->entsize()) * s->entsize() != s->size())
+				throw Exception(_ << "garbage found at end of symbol table " << s->name());
+			_count += s->size() / s->entsize();
+		}
+	if(_count == 0)
+		return;
+
+	// allocate the arena
+	_arena = new t::uint8[_count * (2 * sizeof(t::uint64) + sizeof(t::uint32) + sizeof(t::uint16) + sizeof(t::uint8))];
+	_value = reinterpret_cast<t::uint64 *>(_arena);
+	_size = _value + _count;
+	_name = reinterpret_cast<t::uint32 *>(_size + _count);
+	_shndx = reinterpret_cast<t::uint16 *>(_name + _count);
+	_info = reinterpret_cast<t::uint8 *>(_shndx + _count);
+
+	// fill the arrays
+	int i = 0;
+	try {
+		for(auto s: file.sections())
+			if((s->type() == SHT_SYMTAB || s->type() == SHT_DYNSYM) && s->entsize() != 0)
+				i = fill(i, s);
+	}
+	catch(gel::Exception& e) {
+		delete [] _arena;
+		throw;
+	}
+}
+
+
+///
+FlatSymbolTable::~FlatSymbolTable() {
+	if(_arena != nullptr)
+		delete [] _arena;
+	if(_by_name != nullptr)
+		delete [] _by_name;
+}
+
+
+/**
+ * Fill the arrays with the symbols of the given section.
+ * @param i		Index of the first symbol.
+ * @param sect	Symbol section.
+ * @return		Index after the last symbol of the section.
+ */
+int FlatSymbolTable::fill(int i, Section *sect) {
+
+	// record the string table
+	if(sect->link() >= t::uint32(_file.sections().count()))
+		throw Exception(_ << "bad string table for symbol table " << sect->name());
+	strtab_t st;
+	st.first = i;
+	st.buf = _file.sections()[sect->link()]->content();
+	_strtabs.add(st);
+
+	// get the raw data (the section buffer is not kept if not mapped)
+	const t::uint8 *buf;
+	t::uint8 *tmp = nullptr;
+	if(_file.isMapped())
+		buf = sect->content().bytes();
+	else {
+		tmp = new t::uint8[sect->size()];
+		try {
+			sect->read(tmp);
+		}
+		catch(gel::Exception& e) {
+			delete [] tmp;
+			throw;
+		}
+		buf = tmp;
+	}
+
+	// decode the symbols
+	File::sym_t sym;
+	for(size_t o = 0; o + sect->entsize() <= sect->size(); o += sect->entsize(), i++) {
+		_file.fetchSym(buf + o, sym);
+		_value[i] = sym.value;
+		_size[i] = sym.size;
+		_name[i] = sym.name;
+		_shndx[i] = sym.shndx;
+		_info[i] = sym.info;
+	}
+
+	if(tmp != nullptr)
+		delete [] tmp;
+	return i;
+}
+
+
+/**
+ * Get the name of the symbol at the given index.
+ * @param i		Symbol index.
+ * @return		Symbol name (empty string if out of the string table
+ * 				or not terminated in the string table).
+ */
+cstring FlatSymbolTable::nameOf(int i) const {
+	int j = _strtabs.count() - 1;
+	while(j > 0 && _strtabs[j].first > i)
+		j--;
+	const Buffer& buf = _strtabs[j].buf;
+	if(_name[i] >= buf.size()
+	|| memchr(buf.bytes() + _name[i], '\0', buf.size() - _name[i]) == nullptr)
+		return "";
+	return cstring(reinterpret_cast<const char *>(buf.bytes() + _name[i]));
+}
+
+
+/**
+ * Build the index of symbols sorted by name.
+ */
+void FlatSymbolTable::sortNames() const {
+	auto by_name = new t::uint32[_count];
+	for(int i = 0; i < _count; i++)
+		by_name[i] = i;
+	std::sort(by_name, by_name + _count, [this](t::uint32 a, t::uint32 b) {
+		return strcmp(nameOf(a).chars(), nameOf(b).chars()) < 0;
+	});
+	_by_name = by_name;
+}
+
+
+/**
+ * Find a symbol by its name. If several symbols have the same name,
+ * any of them may be returned.
+ * @param name	Name of the looked symbol.
+ * @return		Found symbol or null symbol.
+ */
+FlatSymbol FlatSymbolTable::find(cstring name) const {
+	if(_count == 0)
+		return FlatSymbol();
+	std::call_once(_by_name_once, [this]() { sortNames(); });
+	int l = 0, h = _count;
+	while(l < h) {
+		int m = (l + h) / 2;
+		int c = strcmp(nameOf(_by_name[m]).chars(), name.chars());
+		if(c == 0)
+			return FlatSymbol(this, _by_name[m]);
+		else if(c < 0)
+			l = m + 1;
+		else
+			h = m;
+	}
+	return FlatSymbol();
+}
+
+/**
+ * @fn File& FlatSymbolTable::file() const;
+ * Get the file owning the symbol table.
+ * @return	Owner file.
+ */
+
+/**
+ * @fn int FlatSymbolTable::count() const;
+ * Get the number of symbols.
+ * @return	Symbol count.
+ */
+
+/**
+ * @fn FlatSymbol FlatSymbolTable::operator[](int i) const;
+ * Get the symbol at the given index.
+ * @param i		Symbol index.
+ * @return		Corresponding symbol.
+ */
+
+} }	// gel::elf
@@ -126,6 +126,7 @@ t::uint32 Unit::load(UnixBuilder& builder, t::uint32 base) {
 					f |= ImageSegment::READABLE;
 				if(h->filesz() != 0)
 					f |= ImageSegment::CONTENT;
+				f |= ImageSegment::SHARED;	// content belongs to the file (and may be mapped read-only)
 				ImageSegment *is = new ImageSegment(_file, h->content(), base + h->vaddr(), f);
 				builder._im->add(is);
 				top = max(top, _base + h->vaddr() + h->memsz());
@@ -516,8 +517,8 @@ ImageSegment *UnixBuilder::buildStack(void) {
 		*_params.sp = sp;
 
 	// create the segment
-	Buffer buf(_prog, new t::uint8[size], size);
-	ImageSegment *seg = new ImageSegment(buf, addr, ImageSegment::WRITABLE | ImageSegment::TO_FREE, "stack");
+	Buffer buf(_prog, allocZeroed(size), size);
+	ImageSegment *seg = new ImageSegment(buf, addr, ImageSegment::WRITABLE | ImageSegment::ZERO_FILL, "stack");
 	if(_params.sp_segment)
 		*_params.sp_segment = seg;
 	_im->add(seg);
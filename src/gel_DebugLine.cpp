@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <algorithm>
 #include <elm/data/util.h>
 
 #include <gel++/DebugLine.h>
@@ -53,20 +54,82 @@ namespace gel {
  * @return	Compilation units using the source file.
  */
 
+///
+DebugLine::File::~File() {
+	if(_ranges != nullptr)
+		delete [] _ranges;
+}
+
 /**
  * Find the address ranges corresponding to the given line number in the current file.
  * @param line	Looked line in the current source file.
  * @param addrs	Used to return the code ranges corresponding to the line.
  */
 void DebugLine::File::find(int line, Vector<Pair<address_t, address_t> >& addrs) const {
+	int n = countRanges();
+	auto r = std::lower_bound(_ranges, _ranges + n, line, [](const LineRange& r, int l) {
+		return r.line < l;
+	});
+	for(; r != _ranges + n && r->line == line; r++)
+		addrs.add(pair(r->low, r->high));
+}
+
+/**
+ * Get the number of line ranges of the file, that is, pieces of code
+ * corresponding to a source line. The ranges are indexed by line the first
+ * time this function, range() or find() is called.
+ * @return	Number of line ranges.
+ */
+int DebugLine::File::countRanges() const {
+	std::call_once(_once, [this]() { buildRanges(); });
+	return _count;
+}
+
+/**
+ * Get a line range of the file. The line ranges are sorted by line.
+ * @param i		Range index (in [0, countRanges()[).
+ * @return		Corresponding line range.
+ */
+const DebugLine::File::LineRange& DebugLine::File::range(int i) const {
+	ASSERT(0 <= i && i < countRanges());
+	return _ranges[i];
+}
+
+/**
+ * Build the line ranges of the file sorted by line.
+ */
+void DebugLine::File::buildRanges() const {
+
+	// collect the ranges
+	Vector<LineRange> ranges;
 	for(auto cu: _units) {
-		const auto& lines = cu->lines();
-		for(int i = 0; i < lines.count() - 1; i++)
-			if(lines[i].file() == this && lines[i].line() == line)
-				addrs.add(pair(lines[i].addr(), lines[i+1].addr()));
+		const auto& lines = cu->table();
+		for(int i = 0; i < lines.count() - 1; i++) {
+			auto l = lines[i];
+			if(l.file() == this && !(l.flags() & LineNumber::END_SEQUENCE)) {
+				LineRange r = { l.line(), l.addr(), lines.addr(i + 1) };
+				ranges.add(r);
+			}
+		}
 	}
+
+	// sort them by line
+	_count = ranges.count();
+	if(_count == 0)
+		return;
+	_ranges = new LineRange[_count];
+	for(int i = 0; i < _count; i++)
+		_ranges[i] = ranges[i];
+	std::stable_sort(_ranges, _ranges + _count, [](const LineRange& a, const LineRange& b) {
+		return a.line < b.line;
+	});
 }
 
+/**
+ * @class DebugLine::File::LineRange
+ * Piece of code [low, high[ corresponding to a source line.
+ */
+
 
 /**
  * @class DebugLine::LineNumber
@@ -98,8 +161,10 @@ t::uint32 flags, t::uint8 isa, t::uint8 desc, t::uint8 opi)
 /**
  * @fn t::uint32 DebugLine::LineNumber::flags() const;
  * Get flags about this code.
- * @return	Code flags (combination of IS_STMT, BASIC_BLOCK, PROLOGUE_END
- * 			and EPILOGUE_BEGIN).
+ * @return	Code flags (combination of IS_STMT, BASIC_BLOCK, PROLOGUE_END,
+ * 			EPILOGUE_BEGIN and END_SEQUENCE). END_SEQUENCE marks the row
+ * 			ending a sequence: it only provides the top address of the previous
+ * 			row.
  */
 
 /**
@@ -126,19 +191,355 @@ t::uint32 flags, t::uint8 isa, t::uint8 desc, t::uint8 opi)
  */
 
 
+/**
+ * @class DebugLine::LineTable
+ * Stores the rows of a compilation unit. The rows are first stored as is
+ * and may be converted into a compact columnar form by compact(): the
+ * addresses are stored as 32-bit offsets from the lowest address, the lines
+ * as 16-bit deltas from a base line per block of 64 rows, the files as
+ * 16-bit indexes in the files of the compilation unit and the flags in
+ * one byte. This takes about 11 bytes per row instead of 40. The ISA,
+ * discriminator and operation index are stored in byte columns that are only
+ * allocated if one of the rows has a non-null value. The few rows that do
+ * not fit this encoding are stored aside in a map.
+ *
+ * In both forms, the rows can be accessed randomly by value but, in compact
+ * form, the rows are rebuilt on access. Only the original form provides
+ * the rows as such (see rows()).
+ */
+
+///
+DebugLine::LineTable::LineTable()
+:	_n(0),
+	_files(nullptr),
+	_base(0),
+	_line_base(nullptr),
+	_addr(nullptr),
+	_line(nullptr),
+	_col(nullptr),
+	_file(nullptr),
+	_flags(nullptr),
+	_isa(nullptr),
+	_disc(nullptr),
+	_opi(nullptr)
+{ }
+
+///
+DebugLine::LineTable::~LineTable() {
+	if(_addr != nullptr) {
+		delete [] _line_base;
+		delete [] _addr;
+		delete [] _line;
+		delete [] _col;
+		delete [] _file;
+		delete [] _flags;
+		delete [] _isa;
+		delete [] _disc;
+		delete [] _opi;
+	}
+}
+
+/**
+ * @fn int DebugLine::LineTable::count() const;
+ * Get the number of rows.
+ * @return	Row count.
+ */
+
+/**
+ * @fn bool DebugLine::LineTable::isCompact() const;
+ * Test if the table is in compact form.
+ * @return	True if the table is compact, false else.
+ */
+
+/**
+ * @fn DebugLine::LineTable::Iter DebugLine::LineTable::begin() const;
+ * Get an iterator on the first row (rows are iterated by value).
+ * @return	Iterator on the first row.
+ */
+
+/**
+ * @fn DebugLine::LineTable::Iter DebugLine::LineTable::end() const;
+ * Get an iterator after the last row.
+ * @return	End iterator.
+ */
+
+/**
+ * @fn const FragTable<DebugLine::LineNumber>& DebugLine::LineTable::rows() const;
+ * Get the rows as stored before compaction. In compact form, this table is
+ * empty and operator[] has to be used.
+ * @return	Table of rows.
+ */
+
+/**
+ * Get the address of a row (faster than operator[] in compact form).
+ * @param i		Row index.
+ * @return		Row address.
+ */
+address_t DebugLine::LineTable::addr(int i) const {
+	ASSERT(0 <= i && i < _n);
+	if(_addr == nullptr)
+		return _lines[i].addr();
+	else if(_flags[i] & WIDE)
+		return _wide.get(i, LineNumber()).addr();
+	else
+		return _base + _addr[i];
+}
+
+/**
+ * Get the flags of a row (faster than operator[] in compact form).
+ * @param i		Row index.
+ * @return		Row flags.
+ */
+t::uint32 DebugLine::LineTable::flags(int i) const {
+	ASSERT(0 <= i && i < _n);
+	if(_addr == nullptr)
+		return _lines[i].flags();
+	else if(_flags[i] & WIDE)
+		return _wide.get(i, LineNumber()).flags();
+	else
+		return _flags[i];
+}
+
+/**
+ * Get a row.
+ * @param i		Row index.
+ * @return		Row at index i.
+ */
+DebugLine::LineNumber DebugLine::LineTable::operator[](int i) const {
+	ASSERT(0 <= i && i < _n);
+	if(_addr == nullptr)
+		return _lines[i];
+	else if(_flags[i] & WIDE)
+		return _wide.get(i, LineNumber());
+	else
+		return LineNumber(
+			_base + _addr[i],
+			(*_files)[_file[i]],
+			_line_base[i >> BLOCK_SHIFT] + _line[i],
+			_col[i],
+			_flags[i],
+			_isa == nullptr ? 0 : _isa[i],
+			_disc == nullptr ? 0 : _disc[i],
+			_opi == nullptr ? 0 : _opi[i]);
+}
+
+/**
+ * Add a row. The table must not be compact.
+ * @param line	Added row.
+ */
+void DebugLine::LineTable::add(const LineNumber& line) {
+	ASSERTP(!isCompact(), "cannot add a row to a compact line table");
+	_lines.add(line);
+	_n++;
+}
+
+/**
+ * Convert the table to the compact form. Once compact, no more row can be
+ * added.
+ * @param files		Files of the compilation unit (the file of a row is stored
+ * 					as an index in this vector).
+ */
+void DebugLine::LineTable::compact(const Vector<File *>& files) {
+	if(isCompact() || _n == 0)
+		return;
+
+	// prepare the columns
+	_files = &files;
+	HashMap<File *, int> fmap;
+	for(int i = 0; i < files.count(); i++)
+		if(!fmap.hasKey(files[i]))
+			fmap.put(files[i], i);
+	_base = _lines[0].addr();
+	for(int i = 1; i < _n; i++)
+		_base = min(_base, _lines[i].addr());
+	_line_base = new int[((_n - 1) >> BLOCK_SHIFT) + 1];
+	_addr = new t::uint32[_n];
+	_line = new t::int16[_n];
+	_col = new t::uint16[_n];
+	_file = new t::uint16[_n];
+	_flags = new t::uint8[_n];
+	for(int i = 0; i < _n; i++) {
+		const LineNumber& l = _lines[i];
+		if(l.isa() != 0 && _isa == nullptr)
+			_isa = new t::uint8[_n];
+		if(l.discriminator() != 0 && _disc == nullptr)
+			_disc = new t::uint8[_n];
+		if(l.op_index() != 0 && _opi == nullptr)
+			_opi = new t::uint8[_n];
+	}
+
+	// encode the rows
+	for(int i = 0; i < _n; i++) {
+		const LineNumber& l = _lines[i];
+		if((i & ((1 << BLOCK_SHIFT) - 1)) == 0)
+			_line_base[i >> BLOCK_SHIFT] = l.line();
+		t::int64 dline = t::int64(l.line()) - _line_base[i >> BLOCK_SHIFT];
+		int file = fmap.get(l.file(), -1);
+		if(l.addr() - _base > type_info<t::uint32>::max
+		|| dline < type_info<t::int16>::min || dline > type_info<t::int16>::max
+		|| l.col() < 0 || l.col() > type_info<t::uint16>::max
+		|| file < 0 || file > type_info<t::uint16>::max
+		|| l.flags() >= WIDE) {
+			_wide.put(i, l);
+			_flags[i] = WIDE;
+		}
+		else {
+			_addr[i] = l.addr() - _base;
+			_line[i] = dline;
+			_col[i] = l.col();
+			_file[i] = file;
+			_flags[i] = l.flags();
+		}
+		if(_isa != nullptr)
+			_isa[i] = l.isa();
+		if(_disc != nullptr)
+			_disc[i] = l.discriminator();
+		if(_opi != nullptr)
+			_opi[i] = l.op_index();
+	}
+	_lines.clear();
+}
+
+
 /**
  * @class CompilationUnit
  * Represents a compilation unit involved in the build of an executable or
  * of a dynamic library.
+ *
+ * The rows of a compilation unit are made of one or several sequences,
+ * each one covering a contiguous address range and ending with a row marked
+ * @ref LineNumber::END_SEQUENCE. The sequences are indexed by address the
+ * first time a lookup is performed: this makes the lookup fast even if the
+ * unit contains thousands of disjoint sequences (as produced by
+ * -ffunction-sections).
+ *
+ * A compilation unit may be lazy: in this case, only the address ranges of
+ * its sequences are known and its rows are decoded (by DebugLine::load())
+ * the first time they are accessed.
+ */
+
+///
+DebugLine::CompilationUnit::CompilationUnit(): _lazy(nullptr), _base(0), _top(0) {
+}
+
+///
+DebugLine::CompilationUnit::~CompilationUnit() {
+}
+
+/**
+ * Make the compilation unit lazy: its rows will be decoded by the given
+ * debug line information the first time they are accessed.
+ * @param dl		Debug line information in charge of decoding the rows.
+ * @param ranges	Address ranges [low, high[ of the sequences of the unit.
+ */
+void DebugLine::CompilationUnit::setLazy(DebugLine *dl, const Vector<Pair<address_t, address_t> >& ranges) {
+	_lazy = dl;
+	_ranges = ranges;
+	_base = 0;
+	_top = 0;
+	for(int i = 0; i < _ranges.count(); i++) {
+		if(i == 0 || _ranges[i].fst < _base)
+			_base = _ranges[i].fst;
+		if(_ranges[i].snd > _top)
+			_top = _ranges[i].snd;
+	}
+}
+
+/**
+ * Ensure that the rows of a lazy compilation unit are decoded.
+ */
+void DebugLine::CompilationUnit::load() const {
+	if(_lazy != nullptr)
+		std::call_once(_once, [this]() { _lazy->load(const_cast<CompilationUnit *>(this)); });
+}
+
+/**
+ * Ensure that the sequences of the compilation unit are indexed.
+ */
+void DebugLine::CompilationUnit::index() const {
+	load();
+	std::call_once(_seq_once, [this]() { buildSequences(); });
+}
+
+/**
+ * Build the index of the sequences of the compilation unit. Rows following
+ * the last sequence end, if any, are considered as an unterminated sequence.
+ * The address range of a lazy unit is fixed at build time and may be read
+ * concurrently: only the range of an eager unit is computed here.
+ */
+void DebugLine::CompilationUnit::buildSequences() const {
+	int first = 0;
+	bool found = false;
+	for(int i = 0; i < _lines.count(); i++)
+		if((_lines.flags(i) & LineNumber::END_SEQUENCE) || i == _lines.count() - 1) {
+			address_t low = _lines.addr(first), high = _lines.addr(i);
+			if(low < high) {
+				_seqs.add(low, high, pair(first, i));
+				if(_lazy == nullptr) {
+					if(!found || low < _base)
+						_base = low;
+					if(!found || high > _top)
+						_top = high;
+				}
+				found = true;
+			}
+			first = i + 1;
+		}
+	_seqs.build();
+}
+
+/**
+ * Count the sequences of the compilation unit.
+ * @return	Sequence count.
+ */
+int DebugLine::CompilationUnit::countSequences() const {
+	index();
+	return _seqs.count();
+}
+
+/**
+ * Get the address range of a sequence (sequences are sorted by address).
+ * @param i		Sequence index.
+ * @return		Sequence address range.
+ */
+range_t DebugLine::CompilationUnit::sequence(int i) const {
+	index();
+	return range_t(_seqs.low(i), _seqs.high(i) - _seqs.low(i));
+}
+
+/**
+ * @fn bool DebugLine::CompilationUnit::isLazy() const;
+ * Test if the compilation unit is decoded lazily.
+ * @return	True if the unit is lazy, false else.
  */
 
 /**
- * @fn const FragTable<DebugLine::Line>& DebugLine::CompilationUnit::lines() const;
  * Get the array of lines in the compilation unit. Notice that the last entry
  * of this array does not represent an actual line but provides the top address of
  * the previous line.
+ *
+ * If the lines are in compact form, this array is empty: use table() that
+ * works whatever the form of the lines.
  * @return	Array of lines.
  */
+const FragTable<DebugLine::LineNumber>& DebugLine::CompilationUnit::lines() const {
+	load();
+	ASSERTP(!_lines.isCompact(), "lines() is not available on compact lines: use table()");
+	return _lines.rows();
+}
+
+/**
+ * @fn const DebugLine::LineTable& DebugLine::CompilationUnit::table() const;
+ * Get the table of lines of the compilation unit. Unlike lines(), the rows
+ * are accessed by value and this works whatever the form of the lines.
+ * @return	Table of lines.
+ */
+
+/**
+ * @fn void DebugLine::CompilationUnit::compact();
+ * Convert the lines of the compilation unit in compact form
+ * (see @ref LineTable).
+ */
 
 /**
  * @fn const Vector<DebugLine::File *>& DebugLine::CompilationUnit::files() const;
@@ -155,28 +556,38 @@ void DebugLine::CompilationUnit::add(const LineNumber& num) {
 }
 
 /**
- * Add a source file to the compilation unit.
+ * Add a source file to the compilation unit. A file may be added several
+ * times (as entries 0 and 1 of the DWARF 5 file table, that both name the
+ * primary source file) but the unit is recorded only once in the file.
  * @param file	Added file.
  */
 void DebugLine::CompilationUnit::add(File *file) {
 	_files.add(file);
-	file->_units.add(this);
+	if(!file->_units.contains(this))
+		file->_units.add(this);
 }
 
 /**
- * Get the base address of the compilation unit.
+ * Get the base address of the compilation unit, that is, the lowest address
+ * of its sequences.
  * @return	Base address.
  */
 address_t DebugLine::CompilationUnit::baseAddress() const {
-	return _lines[0].addr();
+	if(_lazy == nullptr)
+		index();
+	return _base;
 }
 
 /**
- * Get the top address of the compilation unit.
+ * Get the top address of the compilation unit, that is, the highest address
+ * of its sequences. Notice that the sequences may not cover the whole range
+ * [baseAddress(), topAddress()[.
  * @return	Top address.
  */
 address_t DebugLine::CompilationUnit::topAddress() const {
-	return _lines[_lines.count() - 1].addr();
+	if(_lazy == nullptr)
+		index();
+	return _top;
 }
 
 /**
@@ -185,15 +596,93 @@ address_t DebugLine::CompilationUnit::topAddress() const {
  * @return	Compilation unit size in bytes.
  */
 
+/**
+ * Find the row corresponding to the given address. The sequence containing
+ * the address is first looked up and then a binary search is performed
+ * on its rows (sorted by address).
+ * @return	Found row index or -1.
+ */
+int DebugLine::CompilationUnit::find(address_t addr) const {
+	index();
+
+	// find the sequence
+	int s = _seqs.find(addr);
+	if(s < 0)
+		return -1;
+
+	// find the first row after addr (the end row is always after addr)
+	int l = _seqs.data(s).fst, h = _seqs.data(s).snd;
+	while(l < h) {
+		int m = (l + h) / 2;
+		if(_lines.addr(m) <= addr)
+			l = m + 1;
+		else
+			h = m;
+	}
+	return l - 1;
+}
+
 /**
  * Find the line description corresponding to the given address.
+ * This is not available if the lines are in compact form: use
+ * lineAt(address_t, LineNumber&) instead.
  * @return	Found line number or null pointer.
  */
 const DebugLine::LineNumber *DebugLine::CompilationUnit::lineAt(address_t addr) const {
-	for(int i = 0; i < _lines.count() - 1; i++)
-		if(_lines[i].addr() <= addr && addr < _lines[i+1].addr())
-			return &_lines[i];
-	return nullptr;
+	int i = find(addr);
+	return i < 0 ? nullptr : &lines()[i];
+}
+
+/**
+ * Find the line description corresponding to the given address. This
+ * function works whatever the form of the lines.
+ * @param addr	Looked address.
+ * @param line	Set to the found line.
+ * @return		True if the line is found, false else.
+ */
+bool DebugLine::CompilationUnit::lineAt(address_t addr, LineNumber& line) const {
+	int i = find(addr);
+	if(i < 0)
+		return false;
+	line = _lines[i];
+	return true;
+}
+
+
+/**
+ * @class DebugLine::Visitor
+ * Interface to process the lines of the debug information as they are
+ * decoded, without storing them (see elf::DebugLine::visit()). The lines are
+ * provided unit by unit: only the files of the current unit are available.
+ */
+
+///
+DebugLine::Visitor::~Visitor() {
+}
+
+/**
+ * Called when the decoding of a compilation unit starts. Its files are
+ * available but not its lines. The default implementation does nothing.
+ * @param cu	Started compilation unit.
+ */
+void DebugLine::Visitor::startUnit(const CompilationUnit& cu) {
+}
+
+/**
+ * @fn void DebugLine::Visitor::processLine(const CompilationUnit& cu, const LineNumber& line);
+ * Called for each decoded line, in the order of the line program (including
+ * the rows marked @ref LineNumber::END_SEQUENCE).
+ * @param cu	Current compilation unit.
+ * @param line	Decoded line.
+ */
+
+/**
+ * Called when the decoding of a compilation unit ends. After this call,
+ * the unit and its files are released. The default implementation does
+ * nothing.
+ * @param cu	Ended compilation unit.
+ */
+void DebugLine::Visitor::endUnit(const CompilationUnit& cu) {
 }
 
 
@@ -206,6 +695,13 @@ const DebugLine::LineNumber *DebugLine::CompilationUnit::lineAt(address_t addr)
 /**
  * @class DebugLine
  * Provides access to debug source line information of an ELF file.
+ *
+ * Address lookup (lineAt()) is performed in logarithmic time using an index
+ * of the sequences of all compilation units that is built on the first query:
+ * the row is then searched by dichotomy in the found unit. Therefore, the
+ * compilation units must not be changed after the first lookup. If the
+ * compilation units are lazy, the rows are decoded only in the compilation
+ * units hit by the lookups.
  */
 
 /**
@@ -222,14 +718,141 @@ DebugLine::~DebugLine() {
 }
 
 /**
- * Find the line at the given address.
+ * Find the row containing the given address.
+ * @param addr	Looked address.
+ * @param cu	Set to the compilation unit of the found row.
+ * @return		Index of the row in cu or -1.
+ */
+int DebugLine::find(address_t addr, const CompilationUnit *& cu) const {
+	std::call_once(_index_once, [this]() { buildIndex(); });
+	int i = _cu_index.find(addr);
+	if(i < 0)
+		return -1;
+	cu = _cu_index.data(i);
+	return cu->find(addr);
+}
+
+/**
+ * Find the line at the given address. This is not available if the lines
+ * are in compact form: use lineAt(address_t, LineNumber&) instead.
  * @return	Found line or null.
  */
 const DebugLine::LineNumber *DebugLine::lineAt(address_t addr) const {
+	const CompilationUnit *cu;
+	int i = find(addr, cu);
+	return i < 0 ? nullptr : &cu->lines()[i];
+}
+
+/**
+ * Find the line at the given address. This function works whatever the
+ * form of the lines.
+ * @param addr	Looked address.
+ * @param line	Set to the found line.
+ * @return		True if the line is found, false else.
+ */
+bool DebugLine::lineAt(address_t addr, LineNumber& line) const {
+	const CompilationUnit *cu;
+	int i = find(addr, cu);
+	if(i < 0)
+		return false;
+	line = cu->table()[i];
+	return true;
+}
+
+
+/**
+ * Find the lines of a batch of addresses. This is much faster than calling
+ * lineAt() for each address when the batch is big (as for the symbolization
+ * of profiling samples): the addresses are sorted and merged with the rows.
+ * Consecutive addresses falling in the same sequence advance a cursor on
+ * its rows (by galloping then bisecting) instead of searching again the
+ * sequence and its rows.
+ * @param addrs		Looked addresses (in any order).
+ * @param lines		Receives, for each address of addrs at the same index, the
+ * 					found line or an empty line (whose file is null).
+ */
+void DebugLine::linesAt(const Vector<address_t>& addrs, Vector<LineNumber>& lines) const {
+	std::call_once(_index_once, [this]() { buildIndex(); });
+	int n = addrs.count();
+	lines.setLength(n);
+	if(n == 0)
+		return;
+
+	// sort the addresses and find their compilation units
+	address_t *as = new address_t[n];
+	int *is = new int[n], *perm = new int[n];
+	for(int i = 0; i < n; i++) {
+		as[i] = addrs[i];
+		perm[i] = i;
+	}
+	_cu_index.findAll(as, n, is);
+	std::sort(perm, perm + n, [as](int a, int b) {
+		return as[a] < as[b];
+	});
+
+	// merge with the rows of the sequences
+	const CompilationUnit *cu = nullptr;
+	int s = -1, r = 0, last = 0;
+	for(int k = 0; k < n; k++) {
+		int i = perm[k];
+		address_t a = as[i];
+		lines[i] = LineNumber();
+		if(is[i] < 0)
+			continue;
+
+		// find the sequence (unless a is still in the current one)
+		const CompilationUnit *u = _cu_index.data(is[i]);
+		if(u != cu || s < 0 || a >= cu->_seqs.high(s)
+		|| (s + 1 < cu->_seqs.count() && cu->_seqs.low(s + 1) <= a)) {
+			cu = u;
+			cu->index();
+			s = cu->_seqs.find(a);
+			if(s < 0)
+				continue;
+			r = cu->_seqs.data(s).fst;
+			last = cu->_seqs.data(s).snd;
+		}
+
+		// advance the row cursor (the end row of the sequence is after a)
+		const LineTable& t = cu->_lines;
+		int step = 1;
+		while(r + step < last && t.addr(r + step) <= a) {
+			r += step;
+			step *= 2;
+		}
+		int h = min(r + step, last);
+		while(r + 1 < h) {
+			int m = (r + h) / 2;
+			if(t.addr(m) <= a)
+				r = m;
+			else
+				h = m;
+		}
+		lines[i] = t[r];
+	}
+	delete [] as;
+	delete [] is;
+	delete [] perm;
+}
+
+
+/**
+ * Build the address index of the sequences of the compilation units. Only
+ * the sequences are indexed (and not the rows) to keep the index small
+ * compared to the rows. For lazy compilation units, the sequence ranges
+ * recorded at load time are used.
+ */
+void DebugLine::buildIndex() const {
 	for(auto unit: _cus)
-		if(unit->baseAddress() <= addr && addr < unit->topAddress())
-			return unit->lineAt(addr);
-	return nullptr;
+		if(unit->isLazy())
+			for(const auto& r: unit->_ranges)
+				_cu_index.add(r.fst, r.snd, unit);
+		else
+			for(int i = 0; i < unit->countSequences(); i++) {
+				range_t r = unit->sequence(i);
+				_cu_index.add(r.base(), r.top(), unit);
+			}
+	_cu_index.build();
 }
 
 
@@ -241,6 +864,14 @@ void DebugLine::add(CompilationUnit *cu) {
 	_cus.add(cu);
 }
 
+/**
+ * Called to decode the rows of a lazy compilation unit the first time they
+ * are accessed. Must be overridden by the formats supporting lazy units.
+ * @param cu	Compilation unit to decode.
+ */
+void DebugLine::load(CompilationUnit *cu) {
+}
+
 /**
  * Add a source file.
  * @param file	Source ile to add.
@@ -19,6 +19,7 @@
 
 #include <gel++/File.h>
 #include <gel++/Image.h>
+#include <gel++/SymbolIndex.h>
 
 namespace gel {
 
@@ -238,13 +239,16 @@ Section::~Section() { }
 
 /**
  */
-File::File(Manager& manager, sys::Path path): man(manager), _path(path) {
+File::File(Manager& manager, sys::Path path)
+	: man(manager), _path(path), _sym_index(nullptr) {
 }
 
 
 /**
  */
 File::~File(void) {
+	if(_sym_index != nullptr)
+		delete _sym_index;
 }
 
 
@@ -257,6 +261,38 @@ File::~File(void) {
  */
 
 
+/**
+ * Get the index of symbols by address. The index is built by
+ * @ref makeSymbolIndex() the first time this function is called.
+ * @return	Symbol index by address.
+ */
+const SymbolIndex& File::symbolIndex() {
+	std::call_once(_sym_index_once, [this]() { _sym_index = makeSymbolIndex(); });
+	return *_sym_index;
+}
+
+/**
+ * Build the symbol index returned by symbolIndex(). The default
+ * implementation indexes the symbols of symbols(): a format whose symbol
+ * table may hide symbols (like same-named static symbols) has to overload
+ * this function.
+ * @return	Built symbol index.
+ */
+SymbolIndex *File::makeSymbolIndex() {
+	return new SymbolIndex(symbols());
+}
+
+
+/**
+ * Find the symbol containing the given address.
+ * @param a		Looked address.
+ * @return		Symbol containing a or null.
+ */
+Symbol *File::symbolAt(address_t a) {
+	return symbolIndex().lookup(a);
+}
+
+
 /**
  * If the file is of type ELF 32-bit, return handler on it.
  * @return	ELF file handler or null.
@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <elm/compare.h>
 #include <gel++/Image.h>
 
 namespace gel {
@@ -37,7 +38,8 @@ namespace gel {
  * not coming from a file).
  * @param buf	Buffer containing data for the segment.
  * @param addr	Map address of the buffer.
- * @param flags	Flags of the segment (OR combination of @ref WRITABLE, @ref EXECUTABLE and @ref TO_FREE).
+ * @param flags	Flags of the segment (OR combination of @ref WRITABLE, @ref EXECUTABLE and @ref TO_FREE
+ * 				or @ref ZERO_FILL if the buffer has been allocated with allocZeroed()).
  * @param name	Symbolic name of the segment.
  */
 ImageSegment::ImageSegment(Buffer buf, address_t addr, flags_t flags, cstring name)
@@ -46,14 +48,21 @@ ImageSegment::ImageSegment(Buffer buf, address_t addr, flags_t flags, cstring na
 	_seg(0),
 	_base(addr),
 	_buf(buf),
-	_flags(flags)
+	_flags(flags),
+	_pages(nullptr),
+	_copied(0),
+	_dirty(nullptr),
+	_im(nullptr)
 {
 	if(!_name)
 		_name = defaultName(this);
 }
 
 /**
- * Build an image segment from a file and a buffer.
+ * Build an image segment from a file and a buffer. If the buffer belongs to
+ * the file, flags must contain @ref SHARED: the segment is then written
+ * copy-on-write and gets its own copy of the memory when the file is
+ * released by Image::clean().
  * @param file		File containing the segment.
  * @param buf		Buffer providing content of the segment.
  * @param addr		Address in the image of the segment.
@@ -66,7 +75,11 @@ ImageSegment::ImageSegment(File *file, Buffer buf, address_t addr, flags_t flags
 		_seg(0),
 		_base(addr),
 		_buf(buf),
-		_flags(flags)
+		_flags(flags),
+		_pages(nullptr),
+		_copied(0),
+		_dirty(nullptr),
+		_im(nullptr)
 {
 	if(!_name)
 		_name = defaultName(this);
@@ -75,6 +88,14 @@ ImageSegment::ImageSegment(File *file, Buffer buf, address_t addr, flags_t flags
 
 /**
  * Build an image segment from a file segment.
+ *
+ * If the file segment content covers the whole segment, the image segment
+ * shares the buffer of the file segment instead of copying it (the file must
+ * be kept alive as long as the segment). Writes to a shared segment through
+ * map() are copy-on-write: only the written pages are duplicated.
+ * Else the segment is copied in a zero-filled memory whose pages without
+ * content are only allocated when they are written.
+ *
  * @param file		Owner file.
  * @param segment	Segment to build image.
  * @param addr		Address to install the segment to.
@@ -85,21 +106,27 @@ ImageSegment::ImageSegment(File *file, Segment *segment, address_t addr, cstring
 	_file(file),
 	_seg(segment),
 	_base(addr),
-	_flags(TO_FREE)
+	_flags(0),
+	_pages(nullptr),
+	_copied(0),
+	_dirty(nullptr),
+	_im(nullptr)
 {
 	if(segment->isWritable())
 		_flags |= WRITABLE;
 	if(segment->isExecutable())
 		_flags |= EXECUTABLE;
 	Buffer sbuf = segment->buffer();
-	_buf = Buffer(sbuf.decoder(), new t::uint8[segment->size()], segment->size());
-	size_t size = 0;
-	if(segment->hasContent()) {
-		array::copy(_buf.bytes(), sbuf.bytes(), sbuf.size());
-		size = sbuf.size();
+	if(segment->hasContent() && sbuf.size() >= segment->size()) {
+		_buf = Buffer(sbuf.decoder(), sbuf.bytes(), segment->size());
+		_flags |= SHARED;
+	}
+	else {
+		_buf = Buffer(sbuf.decoder(), allocZeroed(segment->size()), segment->size());
+		_flags |= ZERO_FILL;
+		if(segment->hasContent())
+			array::copy(_buf.bytes(), sbuf.bytes(), min(sbuf.size(), segment->size()));
 	}
-	if(size < segment->size())
-		array::clear(_buf.bytes() + size, segment->size() - size);
 	if(!_name)
 		name = defaultName(this);
 }
@@ -109,13 +136,116 @@ ImageSegment::ImageSegment(File *file, Segment *segment, address_t addr, cstring
 ImageSegment::~ImageSegment(void) {
 	if(_flags & TO_FREE)
 		delete [] _buf.bytes();
+	else if(_flags & ZERO_FILL)
+		freeZeroed(_buf.bytes(), _buf.size());
+	if(_pages != nullptr) {
+		for(size_t i = 0; i < pageCount(); i++)
+			delete [] _pages[i];
+		delete [] _pages;
+	}
+	if(_dirty != nullptr)
+		delete [] _dirty;
+}
+
+/**
+ * Get the memory of the segment at the given offset. For a shared segment,
+ * the page containing the offset is duplicated on the first write access.
+ * @param off		Offset in the segment.
+ * @param write		True if the memory is accessed for writing.
+ * @param avail		Receives the number of bytes that can be accessed
+ * 					from the returned pointer.
+ * @return			Pointer to the memory at off.
+ */
+t::uint8 *ImageSegment::map(offset_t off, bool write, size_t& avail) {
+	ASSERT(off < _buf.size());
+	size_t p = off >> PAGE_BITS;
+	if(write && _dirty != nullptr)
+		_dirty[p] = true;
+	if(!isPaged()) {
+		avail = _buf.size() - off;
+		return _buf.bytes() + off;
+	}
+
+	// find the page
+	offset_t poff = off & ((1 << PAGE_BITS) - 1);
+	size_t psize = min(size_t(1) << PAGE_BITS, _buf.size() - (p << PAGE_BITS));
+	avail = psize - poff;
+	if(!(_flags & SHARED))
+		return _buf.bytes() + off;
+
+	// copy it if required
+	if(_pages != nullptr && _pages[p] != nullptr)
+		return _pages[p] + poff;
+	else if(!write)
+		return _buf.bytes() + off;
+	if(_pages == nullptr) {
+		_pages = new t::uint8 *[pageCount()];
+		array::set(_pages, pageCount(), static_cast<t::uint8 *>(nullptr));
+	}
+	_pages[p] = new t::uint8[psize];
+	array::copy(_pages[p], _buf.bytes() + (p << PAGE_BITS), psize);
+	_copied++;
+	return _pages[p] + poff;
+}
+
+/**
+ * Start (or restart) the tracking of the pages written through map().
+ */
+void ImageSegment::track() {
+	if(_dirty == nullptr)
+		_dirty = new bool[pageCount()];
+	array::set(_dirty, pageCount(), false);
+}
+
+/**
+ * Test if a block of memory only contains zeroes.
+ * @param p		Block to test.
+ * @param n		Size of the block.
+ * @return		True if the block is zero-filled, false else.
+ */
+static bool isZero(const t::uint8 *p, size_t n) {
+	for(size_t i = 0; i < n; i++)
+		if(p[i] != 0)
+			return false;
+	return true;
+}
+
+/**
+ * Replace the shared memory of the segment by a private copy
+ * including the pages already written. The copy is allocated
+ * with allocZeroed() and the zero-filled pages (like BSS) are
+ * not copied, leaving them untouched in the new memory.
+ */
+void ImageSegment::materialize() const {
+	if(!(_flags & SHARED))
+		return;
+	t::uint8 *b = allocZeroed(_buf.size());
+	for(size_t i = 0; i < pageCount(); i++) {
+		size_t n = min(size_t(1) << PAGE_BITS, _buf.size() - (i << PAGE_BITS));
+		const t::uint8 *p = _buf.bytes() + (i << PAGE_BITS);
+		if(_pages != nullptr && _pages[i] != nullptr)
+			p = _pages[i];
+		if(!isZero(p, n))
+			array::copy(b + (i << PAGE_BITS), p, n);
+	}
+	if(_pages != nullptr) {
+		for(size_t i = 0; i < pageCount(); i++)
+			delete [] _pages[i];
+		delete [] _pages;
+		_pages = nullptr;
+	}
+	_buf = Buffer(_buf.decoder(), b, _buf.size());
+	_flags = (_flags & ~SHARED) | ZERO_FILL;
+	if(_im != nullptr)
+		_im->flush();
 }
 
 /**
  * Clean up any link with the original file
- * (for memory save).
+ * (for memory save). A shared segment gets its own copy of the memory.
  */
 void ImageSegment::clean(void) {
+	materialize();
 	_file = 0;
 	_seg = 0;
 }
@@ -144,8 +274,15 @@ bool ImageSegment::isWritable() { return _flags & WRITABLE; }
 ///
 bool ImageSegment::hasContent() { return _flags & CONTENT; }
 
-///
-Buffer ImageSegment::buffer() { return _buf; }
+/**
+ * Get the buffer of the segment. A writable shared segment gets its own copy of
+ * the memory first as the buffer may be modified.
+ */
+Buffer ImageSegment::buffer() {
+	if(_pages != nullptr || (_flags & WRITABLE))
+		materialize();
+	return _buf;
+}
 
 /**
  * @fn File *ImageSegment::file(void) const;
@@ -167,14 +304,42 @@ Buffer ImageSegment::buffer() { return _buf; }
 
 /**
  * @fn const Buffer& ImageSegment::buffer(void) const;
- * Get the buffer to access segment data.
+ * Get the buffer to access segment data. If pages of a shared segment
+ * have been written, the segment gets its own copy of the memory first.
  * @return	Segment buffer.
  */
 
+/**
+ * @fn Decoder *ImageSegment::decoder() const;
+ * Get the decoder of the segment data.
+ * @return	Segment decoder.
+ */
+
+/**
+ * @fn bool ImageSegment::isShared() const;
+ * Test if the segment shares its memory with the file segment it comes from.
+ * @return	True if the memory is shared, false else.
+ */
+
+/**
+ * @fn bool ImageSegment::isPaged() const;
+ * Test if the memory of the segment is accessed page by page by map(),
+ * that is, if it is shared or if its written pages are tracked for a
+ * snapshot of the image.
+ * @return	True if the segment is paged, false else.
+ */
+
+/**
+ * @fn int ImageSegment::copiedPages() const;
+ * Get the number of pages of a shared segment that have been duplicated
+ * because of a write.
+ * @return	Number of copied pages.
+ */
+
 /**
  * @fn ImageSegment::flags_t ImageSegment::flags() const;
  * Get the flags of the segment, a OR'ed combination of WRITABLE, EXECUTABLE,
- * CONTENT and STACK.
+ * CONTENT, STACK, TO_FREE, SHARED and ZERO_FILL.
  * @return		Value of flags.
  */
 
@@ -323,14 +488,21 @@ cstring Parameter::getenv(cstring name) const {
  * Build an image using the given file as the program.
  * @param program	Program to use (it is to the user to free it).
  */
-Image::Image(File *program): _prog(program) {
+Image::Image(File *program): _prog(program), _built(false), _last(nullptr), _snap(nullptr) {
 	add(program);
+	flush();
 }
 
 /**
+ * The additional files are released but, unlike clean(), the segments
+ * are not given their own copy of the memory.
  */
 Image::~Image(void) {
-	clean();
+	for(auto s: segments())
+		s->_im = nullptr;
+	for(auto l: files())
+		if(l.file != _prog)
+			delete l.file;
 }
 
 /**
@@ -366,36 +538,250 @@ void Image::add(File *file, address_t base) {
  */
 void Image::add(ImageSegment *segment) {
 	segs.addLast(segment);
+	segment->_im = this;
+	_built = false;
+	flush();
 }
 
 /**
  * Find the segment at the given address.
+ *
+ * As simulators call this function for each memory access, the last found
+ * segment is remembered and tested first: successive accesses usually hit
+ * the same segment. Else the segments are looked up in an index sorted by
+ * address that is (re-)built on the first lookup following an add().
+ *
  * @param address	Looked address.
  * @return			Found segment or null.
  */
 ImageSegment *Image::at(address_t address) {
+	if(_last != nullptr && address - _last->base() < _last->range().size())
+		return _last;
+	return lookup(address);
+}
+
+/**
+ * Slow path of at(): look the address up in the segment index.
+ * @param address	Looked address.
+ * @return			Found segment or null.
+ */
+ImageSegment *Image::lookup(address_t address) {
+	if(!_built) {
+		_index.clear();
+		for(auto s: segments())
+			_index.add(s->base(), s->range().top(), s);
+		_index.build();
+		_built = true;
+	}
+	int i = _index.find(address);
+	if(i < 0)
+		return null<ImageSegment>();
+	_last = _index.data(i);
+	return _last;
+}
+
+/**
+ * @fn T Image::read<T>(address_t a);
+ * Read a value of type T (one of the t::intN or t::uintN types) at the given
+ * address of the image. The value is read according to the decoder of the
+ * containing segment and may span several segments.
+ *
+ * Recently accessed pages are remembered in a small translation cache that
+ * makes the access very fast when the page has already been accessed.
+ *
+ * @param a					Address to read from.
+ * @return					Read value.
+ * @throw gel::Exception	If a part of the value is not mapped in the image.
+ */
+
+/**
+ * @fn void Image::write<T>(address_t a, T v);
+ * Write a value of type T (one of the t::intN or t::uintN types) at the given
+ * address of the image. The value is converted according to the decoder of the
+ * containing segment and may span several segments.
+ * @param a					Address to write to.
+ * @param v					Written value.
+ * @throw gel::Exception	If a part of the value is not mapped in the image.
+ */
+
+/**
+ * @fn void Image::read(address_t a, void *dst, size_t n);
+ * Read a block of bytes from the image, possibly spanning several segments.
+ * @param a					Address of the block.
+ * @param dst				Buffer to copy the bytes to.
+ * @param n					Size of the block in bytes.
+ * @throw gel::Exception	If a part of the block is not mapped in the image.
+ */
+
+/**
+ * @fn void Image::write(address_t a, const void *src, size_t n);
+ * Write a block of bytes to the image, possibly spanning several segments.
+ * @param a					Address of the block.
+ * @param src				Buffer containing the written bytes.
+ * @param n					Size of the block in bytes.
+ * @throw gel::Exception	If a part of the block is not mapped in the image.
+ */
+
+/**
+ * Invalidate the translation cache used by read() and write(). Must be called
+ * when the buffer of a segment of the image is changed outside of the image.
+ */
+void Image::flush() {
+	for(int i = 0; i < TLB_SIZE; i++) {
+		_tlb[i].page = ~address_t(0);
+		_tlb[i].low = _tlb[i].high = 0;
+	}
+	_last = nullptr;
+}
+
+/**
+ * Slow path of read() and write(): copy bytes between the image and the given
+ * buffer, possibly from several segments, and record the translation of the
+ * page of a in the translation cache.
+ * @param a					Image address.
+ * @param p					Buffer to copy bytes to (read) or from (write).
+ * @param n					Number of bytes to copy.
+ * @param write				True to write the image, false to read it.
+ * @return					Decoder of the segment containing a.
+ * @throw gel::Exception	If a part of the block is not mapped in the image.
+ */
+Decoder *Image::transfer(address_t a, t::uint8 *p, size_t n, bool write) {
+	Decoder *dec = nullptr;
+	bool first = true;
+	while(n != 0) {
+		ImageSegment *s = at(a);
+		if(s == nullptr)
+			throw Exception(_ << "no memory at " << format(address_64, a));
+		if(first) {
+			dec = s->decoder();
+			first = false;
+		}
+
+		// get the memory
+		int copied = s->copiedPages();
+		size_t avail;
+		t::uint8 *mem = s->map(a - s->base(), write, avail);
+		if(s->copiedPages() != copied)
+			flush();
+
+		// record the translation
+		offset_t before = a - s->base();
+		if(s->isPaged())
+			before &= (1 << PAGE_BITS) - 1;
+		address_t page = a >> PAGE_BITS;
+		tlb_t& e = _tlb[page & (TLB_SIZE - 1)];
+		e.page = page;
+		e.low = max(page << PAGE_BITS, a - before);
+		e.high = min((page + 1) << PAGE_BITS, a + avail);
+		e.base = a;
+		e.mem = mem;
+		e.dec = s->decoder();
+		e.write = write || !s->isPaged();
+
+		// copy the bytes
+		size_t m = min(n, avail);
+		if(write)
+			array::copy(mem, p, m);
+		else
+			array::copy(p, mem, m);
+		a += m;
+		p += m;
+		n -= m;
+	}
+	return dec;
+}
+
+/**
+ * @class Image::Snapshot
+ * Saved state of the writable segments of an image, obtained by
+ * Image::snapshot() and used to reset the image with Image::restore().
+ */
+
+/**
+ */
+Image::Snapshot::~Snapshot() {
+	for(auto s: _segs)
+		freeZeroed(s.data, s.seg->range().size());
+	if(_im->_snap == this)
+		_im->_snap = nullptr;
+}
+
+/**
+ * Save the state of the writable segments of the image. From now on,
+ * the pages written through read()/write() or ImageSegment::map() are
+ * tracked and restore() only copies back these pages.
+ *
+ * Modifications performed directly in the buffer of a segment are not
+ * tracked and are not undone by restore(). The zero-filled pages of the
+ * segments do not take memory in the snapshot.
+ *
+ * @return	Snapshot of the image (to delete by the caller before the image).
+ */
+Image::Snapshot *Image::snapshot() {
+	Snapshot *snap = new Snapshot(this);
 	for(auto s: segments())
-		if(s->range().contains(address))
-			return s;
-	return null<ImageSegment>();
+		if(s->isWritable()) {
+			Snapshot::seg_t ss = { s, allocZeroed(s->range().size()) };
+			size_t avail;
+			for(offset_t off = 0; off < s->range().size(); off += avail) {
+				const t::uint8 *mem = s->map(off, false, avail);
+				for(size_t i = 0; i < avail; i += 1 << PAGE_BITS) {
+					size_t n = min(size_t(1) << PAGE_BITS, avail - i);
+					if(!isZero(mem + i, n))
+						array::copy(ss.data + off + i, mem + i, n);
+				}
+			}
+			s->track();
+			snap->_segs.add(ss);
+		}
+	flush();
+	_snap = snap;
+	return snap;
+}
+
+/**
+ * Reset the writable segments of the image to the state saved in the given
+ * snapshot. If the snapshot is the last taken or restored one, only the pages
+ * written since are copied back. Else the whole segments are copied back.
+ * @param snap	Snapshot to restore.
+ */
+void Image::restore(Snapshot *snap) {
+	ASSERTP(snap->_im == this, "snapshot of another image");
+	bool full = snap != _snap;
+	for(auto ss: snap->_segs) {
+		ImageSegment *s = ss.seg;
+		size_t avail;
+		for(offset_t off = 0; off < s->range().size(); off += avail) {
+			if(!full && s->_dirty != nullptr && !s->_dirty[off >> PAGE_BITS]) {
+				s->map(off, false, avail);
+				continue;
+			}
+			array::copy(s->map(off, true, avail), ss.data + off, avail);
+		}
+		s->track();
+	}
+	flush();
+	_snap = snap;
 }
 
 /**
  * Get rid of the additional files (usually dynamic libraries)
- * to save memory.
+ * to save memory. The segments sharing the memory of these files
+ * get their own copy of the memory first.
  */
 void Image::clean(void) {
 
+	// clean segments
+	for(auto s: segments())
+		if(s->file() != _prog)
+			s->clean();
+	flush();
+
 	// remove files
 	for(auto l: files())
 		if(l.file != _prog)
 			delete l.file;
 	_links.clear();
-
-	// clean segments
-	for(auto s: segments())
-		if(s->file() != _prog)
-			s->clean();
 }
 
 
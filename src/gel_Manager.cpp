@@ -18,6 +18,9 @@
  */
 
 #include "../config.h"
+#include <atomic>
+#include <new>
+#include <thread>
 #include <elm/compare.h>
 #include <elm/sys/System.h>
 #include <gel++.h>
@@ -29,6 +32,15 @@
 #ifdef HAS_COFFI
 #	include <gel++/coffi/File.h>
 #endif
+#ifndef _WIN32
+#	include <errno.h>
+#	include <fcntl.h>
+#	include <string.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#else
+#	include <stdio.h>
+#endif
 
 namespace gel {
 
@@ -45,39 +57,291 @@ namespace gel {
  */
 Manager Manager::DEFAULT;
 
+/**
+ * @var Manager::flags_t Manager::MAP_FILES;
+ * When set, the ELF files are memory-mapped (read-only) instead of being
+ * read with a stream: section and program header contents then points
+ * directly inside the mapping and are only loaded by the OS page faults
+ * when they are actually accessed. If the mapping cannot be performed,
+ * the files are read as usual.
+ */
+
+/**
+ * @var Manager::flags_t Manager::LAZY_DEBUG_LINES;
+ * When set, the debug line information is decoded lazily: only the address
+ * range of the compilation units is computed when the debug lines are
+ * opened and the rows of a compilation unit are decoded the first time
+ * they are accessed.
+ */
+
+/**
+ * @var Manager::flags_t Manager::PARALLEL_DEBUG_LINES;
+ * When set, the compilation units of the debug line information are
+ * decoded in parallel, using as many threads as the hardware supports.
+ */
+
+/**
+ * @var Manager::flags_t Manager::COMPACT_DEBUG_LINES;
+ * When set, the rows of the debug line information are stored in compact
+ * form (see @ref DebugLine::LineTable) once decoded. The rows are then
+ * only available by value (see DebugLine::CompilationUnit::table() and
+ * DebugLine::lineAt(address_t, LineNumber&)).
+ */
+
+/**
+ * Build a manager.
+ * @param flags		Configuration flags (OR'ed combination of @ref MAP_FILES,
+ *					@ref LAZY_DEBUG_LINES, @ref PARALLEL_DEBUG_LINES,
+ *					@ref COMPACT_DEBUG_LINES).
+ */
+Manager::Manager(flags_t flags): _flags(flags) {
+}
+
+/**
+ * @fn flags_t Manager::flags() const;
+ * Get the configuration flags of the manager.
+ * @return	Configuration flags.
+ */
+
+/**
+ * @fn void Manager::setFlags(flags_t flags);
+ * Change the configuration flags of the manager. Only the files opened
+ * after this call are concerned.
+ * @param flags	New configuration flags.
+ */
+
+/**
+ * @fn bool Manager::isSet(flags_t flags) const;
+ * Test if one of the given flags is set.
+ * @param flags	Flags to test.
+ * @return		True if one of the flags is set, false else.
+ */
+
+/**
+ * @class Manager::Probe
+ * Description of an executable file obtained by @ref Manager::probe()
+ * without opening it as a @ref File.
+ *
+ * @var Manager::Probe::format_t Manager::Probe::format;
+ * Format of the file (NO_FORMAT if it is not a supported executable).
+ *
+ * @var address_type_t Manager::Probe::address_type;
+ * Size of addresses (ELF class for ELF files).
+ *
+ * @var bool Manager::Probe::big_endian;
+ * True if the file is in big-endian.
+ *
+ * @var int Manager::Probe::machine;
+ * Machine as an ELF machine code (PE-COFF machines are translated).
+ *
+ * @var int Manager::Probe::os;
+ * OS as an ELF OS ABI code (0 for PE-COFF).
+ *
+ * @var File::type_t Manager::Probe::type;
+ * Type of the file.
+ */
+
+/**
+ * Build a probe for an unknown format.
+ */
+Manager::Probe::Probe()
+:	format(NO_FORMAT),
+	address_type(address_32),
+	big_endian(false),
+	machine(0),
+	os(0),
+	type(File::no_type)
+{ }
+
+/**
+ * @fn bool Manager::Probe::isKnown() const;
+ * Test if the probed file is in a supported format.
+ * @return	True if the format is supported, false else.
+ */
+
+// size of the block read by probe
+static const int probe_size = 512;
+
+/**
+ * Read a block of a file for probing.
+ * @param path	Path of the file.
+ * @param off	Offset in the file.
+ * @param buf	Buffer to fill.
+ * @param size	Size of the buffer.
+ * @return		Number of read bytes (0 on error).
+ */
+static int probeRead(sys::Path path, t::uint32 off, t::uint8 *buf, int size) {
+#	ifndef _WIN32
+		int fd = ::open(path.toString().toCString().chars(), O_RDONLY);
+		if(fd < 0)
+			return 0;
+		int r = ::pread(fd, buf, size, off);
+		::close(fd);
+		return r < 0 ? 0 : r;
+#	else
+		FILE *f = fopen(path.toString().toCString().chars(), "rb");
+		if(f == nullptr)
+			return 0;
+		int r = 0;
+		if(fseek(f, off, SEEK_SET) == 0)
+			r = fread(buf, 1, size, f);
+		fclose(f);
+		return r;
+#	endif
+}
+
+/**
+ * Identify the format of an executable file and get its main properties
+ * (class, endianness, machine, OS and type) from its header. This function
+ * does not throw exceptions and does not build any object: it is meant to
+ * quickly reject or classify files. Only one small read is performed
+ * (two for PE-COFF files with a far PE header).
+ * @param path	Path of the file to probe.
+ * @return		Probe result (with format NO_FORMAT if the file cannot be read
+ * 				or is not a supported executable).
+ */
+Manager::Probe Manager::probe(sys::Path path) {
+	Probe p;
+	t::uint8 buf[probe_size];
+	int size = probeRead(path, 0, buf, probe_size);
+	if(size < 4)
+		return p;
+
+	// ELF file
+	if(elf::File::matches(buf)) {
+		if(size < 20)
+			return p;
+		switch(buf[EI_CLASS]) {
+		case ELFCLASS32:	p.address_type = address_32; break;
+		case ELFCLASS64:	p.address_type = address_64; break;
+		default:			return p;
+		}
+		switch(buf[EI_DATA]) {
+		case ELFDATA2LSB:	p.big_endian = false; break;
+		case ELFDATA2MSB:	p.big_endian = true; break;
+		default:			return p;
+		}
+		auto half = [&](int o) {
+			return p.big_endian
+				? (t::uint16(buf[o]) << 8) | buf[o + 1]
+				: (t::uint16(buf[o + 1]) << 8) | buf[o];
+		};
+		p.type = elf::File::typeOf(half(16));
+		p.machine = half(18);
+		p.os = buf[EI_OSABI];
+		p.format = Probe::ELF_FORMAT;
+		return p;
+	}
+
+	// PE-COFF file
+	else if(pecoff::File::matches(buf)) {
+		if(size < 0x40)
+			return p;
+		t::uint32 off = buf[0x3C] | (buf[0x3D] << 8) | (buf[0x3E] << 16) | (t::uint32(buf[0x3F]) << 24);
+		const t::uint8 *h;
+		if(t::uint64(off) + 26 <= t::uint64(size))
+			h = buf + off;
+		else if(probeRead(path, off, buf, 26) == 26)
+			h = buf;
+		else
+			return p;
+		if(h[0] != 'P' || h[1] != 'E' || h[2] != '\0' || h[3] != '\0')
+			return p;
+		t::uint16 machine = h[4] | (h[5] << 8);
+		t::uint16 characteristics = h[22] | (h[23] << 8);
+		t::uint16 magic = h[24] | (h[25] << 8);
+		p.address_type = pecoff::File::addressTypeOf(characteristics, magic);
+		p.machine = pecoff::File::elfMachineOf(machine);
+		p.type = pecoff::File::typeOf(characteristics);
+		p.format = Probe::PECOFF_FORMAT;
+		return p;
+	}
+
+	return p;
+}
+
+
+#ifndef _WIN32
+/**
+ * Open a file for reading and read its identification bytes.
+ * @param path				Path to the file.
+ * @param ident				Receives the first EI_NIDENT bytes of the file.
+ * @param size				Receives the number of read bytes.
+ * @return					File descriptor.
+ * @throw gel::Exception	If the file cannot be opened.
+ */
+static int openIdent(sys::Path path, t::uint8 *ident, ssize_t& size) {
+	int fd = ::open(path.toString().toCString().chars(), O_RDONLY);
+	if(fd < 0)
+		throw Exception(_ << "cannot open " << path << ": " << strerror(errno));
+	do
+		size = ::pread(fd, ident, EI_NIDENT, 0);
+	while(size < 0 && errno == EINTR);
+	return fd;
+}
+#endif
+
+
 /**
  * Open an executable file. Caller is in charge of releasing
  * the obtained file.
+ *
+ * When supported by the OS, the identification of the file is read from
+ * a file descriptor that is kept to read an ELF file.
+ *
  * @param path				Path to the file.
  * @return					Open file.
  * @throw gel::Exception	If there is an error.
  */
 File *Manager::openFile(sys::Path path) {
+
+	// is it ELF?
+#	ifndef _WIN32
+		t::uint8 ident[EI_NIDENT];
+		ssize_t r;
+		int fd = openIdent(path, ident, r);
+		if(r >= 4 && elf::File::matches(ident)) {
+			if(r < EI_NIDENT) {
+				::close(fd);
+				throw Exception("not an ELF file");
+			}
+			return makeELFFile(path, ident, nullptr, fd);
+		}
+		::close(fd);
+#	endif
+
+	io::RandomAccessStream *s = nullptr;
 	try {
-		io::RandomAccessStream *s = sys::System::openRandomFile(path, sys::System::READ);
+		s = sys::System::openRandomFile(path, sys::System::READ);
 
 		// read first four bytes
 		t::uint8 magic[4];
 		t::size size = s->read(magic, sizeof(magic));
 		s->resetPos();
-		if(size < sizeof(magic))
+		if(size < sizeof(magic)) {
+			delete s;
 			throw Exception("does not seem to be a binary!");
-		
-		// is it ELF?
-		if(elf::File::matches(magic))
-			return openELFFile(path, s);
+		}
+
+#		ifdef _WIN32
+			if(elf::File::matches(magic))
+				return openELFFile(path, s);
+#		endif
 
 		// is it COFF by COFFI?
 #		ifdef HAS_COFFI
-		else if(coffi::File::matches(magic))
+			if(coffi::File::matches(magic)) {
+				delete s;
 				return new coffi::File(*this, path);
+			}
 #		endif
 
 		// is it PE-COFF?
-		else if(pecoff::File::matches(magic))
+		if(pecoff::File::matches(magic))
 			return openPECOFFFile(path, s);
-			
+
 		// else I don't know
+		delete s;
 		throw Exception(_
 			<< "unknown executable format with magic: "
 			<< io::hex(magic[0])
@@ -95,19 +359,34 @@ File *Manager::openFile(sys::Path path) {
 /**
  * Open an ELF executable file. Caller is in charge of releasing
  * the obtained file.
+ *
+ * When supported by the OS, the file is read from a file descriptor
+ * allowing concurrent positional reads and memory mapping.
+ *
  * @param path				Path to the file.
  * @return					Open file.
  * @throw gel::Exception	If there is an error.
  */
 elf::File *Manager::openELFFile(sys::Path path) {
-	io::RandomAccessStream *s = nullptr;
-	try {
-		s = sys::System::openRandomFile(path, sys::System::READ);
-		return openELFFile(path, s);
-	}
-	catch(sys::SystemException& e) {
-		throw Exception(e.message());
-	}
+#	ifndef _WIN32
+		t::uint8 ident[EI_NIDENT];
+		ssize_t r;
+		int fd = openIdent(path, ident, r);
+		if(r < EI_NIDENT) {
+			::close(fd);
+			throw Exception("not an ELF file");
+		}
+		return makeELFFile(path, ident, nullptr, fd);
+#	else
+		io::RandomAccessStream *s = nullptr;
+		try {
+			s = sys::System::openRandomFile(path, sys::System::READ);
+			return openELFFile(path, s);
+		}
+		catch(sys::SystemException& e) {
+			throw Exception(e.message());
+		}
+#	endif
 }
 
 
@@ -127,17 +406,7 @@ elf::File *Manager::openELFFile(sys::Path path, io::RandomAccessStream *stream)
 		int bufs = stream->read(buf, sizeof(buf));
 		if(bufs < EI_NIDENT)
 			throw Exception("not an ELF file");
-
-		// is it ELF?
-		if(!elf::File::matches(buf))
-			throw Exception("bad header in ELF");
-
-		// open the right ELF
-		switch(buf[EI_CLASS]) {
-		case ELFCLASS32:	return new elf::File32(*this, path, stream);
-		case ELFCLASS64:	return new elf::File64(*this, path, stream);
-		default:			throw Exception(_ << "unknown ELF class: " << io::hex(buf[EI_CLASS]));
-		}
+		return makeELFFile(path, buf, stream, -1);
 	}
 	catch(sys::SystemException& e) {
 		throw Exception(e.message());
@@ -146,6 +415,44 @@ elf::File *Manager::openELFFile(sys::Path path, io::RandomAccessStream *stream)
 }
 
 
+/**
+ * Build the ELF file object matching the given identification.
+ * @param path				Path to the file.
+ * @param ident				Identification bytes of the file (EI_NIDENT bytes).
+ * @param stream			Stream to read from (null to use fd).
+ * @param fd				File descriptor to read from if stream is null
+ * 							(closed in case of error).
+ * @return					Open file.
+ * @throw gel::Exception	If there is an error.
+ */
+elf::File *Manager::makeELFFile(sys::Path path, t::uint8 *ident, io::RandomAccessStream *stream, int fd) {
+
+	// is it ELF?
+	if(!elf::File::matches(ident) || (ident[EI_CLASS] != ELFCLASS32 && ident[EI_CLASS] != ELFCLASS64)) {
+#		ifndef _WIN32
+			if(stream == nullptr)
+				::close(fd);
+#		endif
+		if(!elf::File::matches(ident))
+			throw Exception("bad header in ELF");
+		else
+			throw Exception(_ << "unknown ELF class: " << io::hex(ident[EI_CLASS]));
+	}
+
+	// open the right ELF
+	elf::File *file;
+	if(ident[EI_CLASS] == ELFCLASS32)
+		file = new elf::File32(*this, path, stream, fd);
+	else
+		file = new elf::File64(*this, path, stream, fd);
+
+	// map it if required
+	if(isSet(MAP_FILES) && !file->map())
+		onError(level_warning, _ << "cannot map " << path << ", falling back to stream reading");
+	return file;
+}
+
+
 /**
  * Open a PE-COFF executable file. Caller is in charge of releasing
  * the obtained file.
@@ -159,6 +466,147 @@ pecoff::File *Manager::openPECOFFFile(sys::Path path, io::RandomAccessStream *st
 }
 
 
+/**
+ * @class Manager::OpenOptions
+ * Options of a batch open performed by @ref Manager::openAll().
+ *
+ * @var int Manager::OpenOptions::threads;
+ * Number of threads used to open the files (0, the default, means as many
+ * as the hardware supports).
+ *
+ * @var bool Manager::OpenOptions::load_headers;
+ * If true, the program headers (or segments) are parsed after opening.
+ *
+ * @var bool Manager::OpenOptions::load_sections;
+ * If true, the section headers are parsed after opening.
+ *
+ * @var bool Manager::OpenOptions::load_symbols;
+ * If true, the symbol table is built after opening.
+ */
+
+/*** Default batch open options. */
+const Manager::OpenOptions Manager::OpenOptions::null;
+
+/**
+ * Build default options: automatic thread count and no pre-parsing.
+ */
+Manager::OpenOptions::OpenOptions()
+:	threads(0),
+	load_headers(false),
+	load_sections(false),
+	load_symbols(false)
+{ }
+
+/**
+ * @class Manager::OpenResult
+ * Result of the opening of one file by @ref Manager::openAll(): either
+ * the opened file or the error message.
+ *
+ * @var sys::Path Manager::OpenResult::path;
+ * Path of the file.
+ *
+ * @var File *Manager::OpenResult::file;
+ * Opened file (the caller is in charge of releasing it) or null if an
+ * error arose.
+ *
+ * @var string Manager::OpenResult::error;
+ * Error message if the opening or the pre-parsing failed.
+ */
+
+/**
+ * @fn bool Manager::OpenResult::succeeded() const;
+ * Test if the file has been successfully opened.
+ * @return	True if the file is opened, false else.
+ */
+
+/**
+ * Open and, optionally, pre-parse several files in parallel. The files
+ * are distributed over a pool of threads and, in results, the i-th
+ * entry describes the i-th path: an error on one file (whatever the raised
+ * exception) does not stop the processing of the other files. The caller
+ * is in charge of releasing the opened files.
+ *
+ * Notice that the error handler of the manager may be called concurrently
+ * from several threads.
+ *
+ * @param paths		Paths of the files to open.
+ * @param results	Filled with one result per path.
+ * @param options	Options of the opening (thread count, pre-parsing).
+ */
+void Manager::openAll(const Vector<sys::Path>& paths, Vector<OpenResult>& results, const OpenOptions& options) {
+	int n = paths.count();
+	results.setLength(n);
+	for(int i = 0; i < n; i++) {
+		results[i].path = paths[i];
+		results[i].file = nullptr;
+		results[i].error = "";
+	}
+	if(n == 0)
+		return;
+
+	// process the files
+	std::atomic<int> next(0);
+	auto work = [&]() {
+		for(int i = next++; i < n; i = next++) {
+			OpenResult& r = results[i];
+			File *file = nullptr;
+			try {
+				file = openFile(r.path);
+				auto elf = file->toELF();
+				if(options.load_headers) {
+					if(elf != nullptr)
+						elf->programHeaders();
+					else
+						file->count();
+				}
+				if(options.load_sections) {
+					if(elf != nullptr)
+						elf->sections();
+					else
+						file->countSections();
+				}
+				if(options.load_symbols)
+					file->symbols();
+				r.file = file;
+			}
+			catch(gel::Exception& e) {
+				if(file != nullptr)
+					delete file;
+				r.error = e.message();
+			}
+			catch(MessageException& e) {
+				if(file != nullptr)
+					delete file;
+				r.error = e.message();
+			}
+			catch(std::exception& e) {
+				if(file != nullptr)
+					delete file;
+				r.error = e.what();
+			}
+			catch(...) {
+				if(file != nullptr)
+					delete file;
+				r.error = "unexpected error";
+			}
+		}
+	};
+
+	// launch the pool
+	int tn = options.threads;
+	if(tn <= 0)
+		tn = std::thread::hardware_concurrency();
+	tn = max(1, min(tn, n));
+	std::thread *pool = new std::thread[tn - 1];
+	for(int i = 0; i < tn - 1; i++)
+		pool[i] = std::thread(work);
+	work();
+	for(int i = 0; i < tn - 1; i++)
+		pool[i].join();
+	delete [] pool;
+}
+
+
 /**
  * Format an address for output.
  * @param t	Type of address.
@@ -176,6 +624,49 @@ io::IntFormat format(address_type_t t, address_t a) {
 }
 
 
+// size from which zero-filled memory is mapped
+static const size_t ZERO_MAP_SIZE = 16 << 12;
+
+/**
+ * Allocate a block of memory initialized to zero. Big blocks are
+ * obtained from an anonymous mapping: their pages share the zero page
+ * of the OS and are only actually allocated when they are written. This
+ * is well suited to big zero-filled areas (BSS, stack, etc) that are
+ * scarcely used.
+ * @param size	Size of the block in bytes.
+ * @return		Allocated block (to release with freeZeroed()).
+ * @throw std::bad_alloc	If there is no more memory.
+ */
+t::uint8 *allocZeroed(size_t size) {
+#	ifndef _WIN32
+		if(size >= ZERO_MAP_SIZE) {
+			void *m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if(m == MAP_FAILED)
+				throw std::bad_alloc();
+			return static_cast<t::uint8 *>(m);
+		}
+#	endif
+	t::uint8 *p = new t::uint8[size];
+	array::set(p, size, t::uint8(0));
+	return p;
+}
+
+/**
+ * Release a block allocated with allocZeroed().
+ * @param p		Released block.
+ * @param size	Size of the block (as passed to allocZeroed()).
+ */
+void freeZeroed(t::uint8 *p, size_t size) {
+#	ifndef _WIN32
+		if(size >= ZERO_MAP_SIZE) {
+			munmap(p, size);
+			return;
+		}
+#	endif
+	delete [] p;
+}
+
+
 /**
  * @class Decoder
  * Decoders are used to convert data find in executable files,
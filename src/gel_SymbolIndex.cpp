@@ -0,0 +1,155 @@
+/*
+ * GEL++ SymbolIndex class
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <algorithm>
+#include <elm/data/Vector.h>
+#include <gel++/SymbolIndex.h>
+
+namespace gel {
+
+/**
+ * @class SymbolIndex
+ * Index of the symbols of a file by address: it answers the question
+ * "which symbol contains address a?" in logarithmic time.
+ *
+ * Only symbols of type @ref Symbol::FUNC or @ref Symbol::DATA are indexed
+ * (symbols with both a null value and a null size are considered as
+ * undefined and ignored). A symbol covers the interval [value, value + size[.
+ * As some formats (like PE-COFF) or some hand-written symbols have no size,
+ * a symbol with a null size is assumed to extend up to the start of the next
+ * symbol.
+ *
+ * The lookup itself is performed by an @ref IntervalIndex: overlapping
+ * symbols are supported and the returned symbol is the one with the greatest
+ * start address containing the looked address.
+ *
+ * @ingroup gel
+ */
+
+/**
+ * Build the index from the given symbol table.
+ * @param symtab	Symbol table to index.
+ */
+SymbolIndex::SymbolIndex(const SymbolTable& symtab) {
+	Vector<Symbol *> syms;
+	for(auto s: symtab)
+		syms.add(s);
+	build(syms);
+}
+
+/**
+ * Build the index from the given symbols (that may have the same name,
+ * unlike the symbols of a symbol table).
+ * @param syms	Symbols to index.
+ */
+SymbolIndex::SymbolIndex(const Vector<Symbol *>& syms) {
+	build(syms);
+}
+
+/**
+ * Build the index.
+ * @param all	Symbols to index.
+ */
+void SymbolIndex::build(const Vector<Symbol *>& all) {
+
+	// select the symbols
+	Vector<Symbol *> sel;
+	for(auto s: all)
+		if((s->type() == Symbol::FUNC || s->type() == Symbol::DATA)
+		&& (s->value() != 0 || s->size() != 0))
+			sel.add(s);
+	int n = sel.count();
+	if(n == 0)
+		return;
+
+	// sort them by address (needed to extend null-sized symbols)
+	Symbol **syms = new Symbol *[n];
+	for(int i = 0; i < n; i++)
+		syms[i] = sel[i];
+	std::stable_sort(syms, syms + n, [](Symbol *a, Symbol *b) {
+		return a->value() < b->value();
+	});
+
+	// build the intervals
+	for(int i = 0; i < n; i++) {
+		address_t low = syms[i]->value(), high;
+		if(syms[i]->size() != 0)
+			high = low + syms[i]->size();
+		else {
+			int j = i + 1;
+			while(j < n && syms[j]->value() == low)
+				j++;
+			high = j < n ? syms[j]->value() : low + 1;
+		}
+		_index.add(low, high, syms[i]);
+	}
+	delete [] syms;
+	_index.build();
+}
+
+
+/**
+ * @fn int SymbolIndex::find(address_t a) const;
+ * Find the symbol containing the given address.
+ * @param a		Looked address.
+ * @return		Index of the symbol (in the sorted order) or -1 if not found.
+ */
+
+/**
+ * @fn Symbol *SymbolIndex::lookup(address_t a) const;
+ * Find the symbol containing the given address.
+ * @param a		Looked address.
+ * @return		Found symbol or null.
+ */
+
+/**
+ * @fn int SymbolIndex::count() const;
+ * Get the number of indexed symbols.
+ * @return	Indexed symbol count.
+ */
+
+/**
+ * @fn Symbol *SymbolIndex::symbol(int i) const;
+ * Get a symbol by its index in the address order.
+ * @param i		Symbol index.
+ * @return		Corresponding symbol.
+ */
+
+/**
+ * @fn address_t SymbolIndex::low(int i) const;
+ * Get the start address of the interval covered by the symbol i.
+ * @param i		Symbol index.
+ * @return		Start address.
+ */
+
+/**
+ * @fn address_t SymbolIndex::high(int i) const;
+ * Get the end address (excluded) of the interval covered by the symbol i.
+ * @param i		Symbol index.
+ * @return		End address.
+ */
+
+/**
+ * @fn range_t SymbolIndex::range(int i) const;
+ * Get the address range covered by the symbol i.
+ * @param i		Symbol index.
+ * @return		Covered range.
+ */
+
+}	// gel
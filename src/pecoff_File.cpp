@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
  */
 
+#include <string.h>
 #include <elm/io/RandomAccessStream.h>
 #include <elm/sys/System.h>
 
@@ -306,7 +307,8 @@ File::File(Manager& manager, sys::Path path, io::RandomAccessStream *stream_):
 	_section_table(nullptr),
 	_symbol_table(nullptr),
 	_string_table(nullptr),
-	_string_table_size(0)
+	_string_table_size(0),
+	_symtab(nullptr)
 {
 	try {
 
@@ -330,6 +332,7 @@ File::File(Manager& manager, sys::Path path, io::RandomAccessStream *stream_):
 		swap(_coff_header.machine);
 		swap(_coff_header.number_of_sections);
 		swap(_coff_header.time_date_stamp);
+		swap(_coff_header.pointer_to_symbol_table);
 		swap(_coff_header.number_of_symbols);
 		swap(_coff_header.size_of_optional_header);
 		swap(_coff_header.characteristics);
@@ -516,6 +519,11 @@ File::~File() {
 		delete [] _symbol_table;
 	if(_string_table != nullptr)
 		delete [] _string_table;
+	if(_symtab != nullptr) {
+		for(auto sym: *_symtab)
+			delete sym;
+		delete _symtab;
+	}
 	deleteAll(sects);
 }
 
@@ -558,7 +566,16 @@ string File::os() const {
 
 ///
 int File::elfMachine() const {
-	switch(_coff_header.machine) {
+	return elfMachineOf(_coff_header.machine);
+}
+
+/**
+ * Convert a PE-COFF machine code to the corresponding ELF machine code.
+ * @param machine	PE-COFF machine code.
+ * @return			ELF machine code (0 if there is no equivalent).
+ */
+int File::elfMachineOf(t::uint16 machine) {
+	switch(machine) {
 	case IMAGE_FILE_MACHINE_AM33:			return 89;
 	case IMAGE_FILE_MACHINE_ARM:			return 40;
 	case IMAGE_FILE_MACHINE_ARM64:			return 183;
@@ -633,9 +650,18 @@ void File::move(offset_t offset) {
 
 ///
 File::type_t File::type() {
-	if((_coff_header.characteristics & IMAGE_FILE_EXECUTABLE_IMAGE) != 0)
+	return typeOf(_coff_header.characteristics);
+}
+
+/**
+ * Compute the file type from the characteristics of the COFF header.
+ * @param characteristics	COFF header characteristics.
+ * @return					File type.
+ */
+File::type_t File::typeOf(t::uint16 characteristics) {
+	if((characteristics & IMAGE_FILE_EXECUTABLE_IMAGE) != 0)
 		return program;
-	else if((_coff_header.characteristics & IMAGE_FILE_DLL) != 0)
+	else if((characteristics & IMAGE_FILE_DLL) != 0)
 		return library;
 	else
 		return no_type;
@@ -648,7 +674,20 @@ bool File::isBigEndian() {
 
 ///
 address_type_t File::addressType() {
-	if((_coff_header.characteristics & IMAGE_FILE_32BIT_MACHINE) != 0)
+	return addressTypeOf(_coff_header.characteristics, _standard_coff_fields.magic);
+}
+
+/**
+ * Compute the address type from the characteristics of the COFF header
+ * and from the magic of the optional header.
+ * @param characteristics	COFF header characteristics.
+ * @param magic				Optional header magic (PE32 or PE32P).
+ * @return					Address type.
+ */
+address_type_t File::addressTypeOf(t::uint16 characteristics, t::uint16 magic) {
+	if(magic == PE32P)
+		return address_64;
+	else if((characteristics & IMAGE_FILE_32BIT_MACHINE) != 0)
 		return address_32;
 	else
 		return address_16;
@@ -674,13 +713,151 @@ Image *File::make(const Parameter& params) {
 	return nullptr;
 }
 
-///
+/**
+ * Symbol of a PE-COFF file. As PE-COFF does not record the size of symbols,
+ * the size is always 0.
+ * @ingroup pecoff
+ */
+class Symbol: public gel::Symbol {
+public:
+	Symbol(string name, address_t value, type_t type, bind_t bind)
+		: _name(name), _value(value), _type(type), _bind(bind) { }
+	cstring name() override { return _name.toCString(); }
+	t::uint64 value() override { return _value; }
+	t::uint64 size() override { return 0; }
+	type_t type() override { return _type; }
+	bind_t bind() override { return _bind; }
+private:
+	string _name;
+	address_t _value;
+	type_t _type;
+	bind_t _bind;
+};
+
+/**
+ * Get the symbols of the file. Only the symbols defined in a section
+ * and with an external, static (but section definitions) or weak external
+ * storage class are considered. Their value is converted to an address
+ * in the loaded image.
+ * @throw Exception	If there is an IO error.
+ */
 const SymbolTable& File::symbols() {
+	if(_symtab != nullptr)
+		return *_symtab;
+	SymbolTable *symtab = new SymbolTable;
+	if(_coff_header.pointer_to_symbol_table == 0 || _coff_header.number_of_symbols == 0) {
+		_symtab = symtab;
+		return *_symtab;
+	}
+	try {
+		readSymbols(*symtab);
+	}
+	catch(Exception& e) {
+		for(auto sym: *symtab)
+			delete sym;
+		delete symtab;
+		throw;
+	}
+	_symtab = symtab;
+	return *_symtab;
+}
 
+/**
+ * Read the symbols of the file.
+ * @param symtab	Symbol table to fill.
+ * @throw Exception	If there is an IO error.
+ */
+void File::readSymbols(SymbolTable& symtab) {
+
+	// read the symbol table
+	int n = _coff_header.number_of_symbols;
+	t::uint8 *buf = new t::uint8[18 * n];
+	try {
+		move(_coff_header.pointer_to_symbol_table);
+		read(buf, 18 * n);
+	}
+	catch(Exception& e) {
+		delete [] buf;
+		throw;
+	}
+	if(_symbol_table != nullptr)
+		delete [] _symbol_table;
+	_symbol_table = new symbol_t[n];
+	for(int i = 0; i < n; i++) {
+		// symbol_t is not padded! Size is 18 and not 20!
+		const t::uint8 *p = buf + 18 * i;
+		symbol_t& s = _symbol_table[i];
+		memcpy(s.name.short_name, p, 8);
+		memcpy(&s.value, p + 8, 4);
+		memcpy(&s.section_number, p + 12, 2);
+		memcpy(&s.type, p + 14, 2);
+		s.storage_class = p[16];
+		s.number_of_aux_symbols = p[17];
+		if(s.name.w.zeroes == 0)		// else the name is inline
+			swap(s.name.w.offset);
+		swap(s.value);
+		swap(s.section_number);
+		swap(s.type);
+	}
+	delete [] buf;
+
+	// build the symbols
+	for(int i = 0; i < n; i += 1 + _symbol_table[i].number_of_aux_symbols) {
+		const symbol_t& s = _symbol_table[i];
+		t::int16 sn = s.section_number;
+		if(sn <= 0 || sn > sects.count())
+			continue;
+
+		// get binding
+		Symbol::bind_t bind;
+		switch(s.storage_class) {
+		case IMAGE_SYM_CLASS_EXTERNAL:
+			bind = Symbol::GLOBAL;
+			break;
+		case IMAGE_SYM_CLASS_STATIC:
+			if(s.number_of_aux_symbols != 0)
+				continue;
+			bind = Symbol::LOCAL;
+			break;
+		case IMAGE_SYM_CLASS_WEAK_EXTERNAL:
+			bind = Symbol::WEAK;
+			break;
+		default:
+			continue;
+		}
+
+		// get type
+		Section *sect = sects[sn - 1];
+		Symbol::type_t type;
+		if((s.type >> 4) == IMAGE_SYM_DTYPE_FUNCTION || sect->isExecutable())
+			type = Symbol::FUNC;
+		else
+			type = Symbol::DATA;
+
+		// build the symbol
+		string name;
+		if(s.name.w.zeroes == 0)
+			name = getString(s.name.w.offset);
+		else if(s.name.short_name[7] == '\0')
+			name = s.name.short_name;
+		else
+			name = string(s.name.short_name, 8);
+		auto sym = new Symbol(name,
+			_windows_specific_fields.image_base + sect->header().virtual_address + s.value,
+			type, bind);
+		if(symtab.hasKey(sym->name()))
+			delete sym;
+		else
+			symtab.put(sym->name(), sym);
+	}
 }
 
 /**
  * Get the the string from the string table at the given offset.
+ * @param offset	Offset of the string (from the start of the string table,
+ * 					that is, including its 4-byte size).
+ * @return			String or an empty string if the offset is out of the
+ * 					table or the string is not terminated inside it.
  * @throw Exception	If there is an IO error.
  */
 cstring File::getString(t::uint32 offset) {
@@ -689,10 +866,20 @@ cstring File::getString(t::uint32 offset) {
 		stream->moveTo(_coff_header.pointer_to_symbol_table + 18 * _coff_header.number_of_symbols);
 		read(&_string_table_size, sizeof(_string_table_size));
 		swap(_string_table_size);
-		_string_table_size -= 4;
-		_string_table = new char[_string_table_size];
-		read(_string_table, _string_table_size);
+		_string_table_size = _string_table_size < 4 ? 0 : _string_table_size - 4;
+		char *table = new char[_string_table_size];
+		try {
+			read(table, _string_table_size);
+		}
+		catch(Exception& e) {
+			delete [] table;
+			throw;
+		}
+		_string_table = table;
 	}
+	if(offset < 4 || offset - 4 >= _string_table_size
+	|| memchr(_string_table + offset - 4, '\0', _string_table_size - (offset - 4)) == nullptr)
+		return "";
 	return _string_table + offset - 4;
 }
 
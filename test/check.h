@@ -0,0 +1,37 @@
+/*
+ * GEL++ test checks
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_TEST_CHECK_H_
+#define GELPP_TEST_CHECK_H_
+
+#include <elm/io.h>
+
+// number of failed checks (the test returns it as exit code)
+static int failed = 0;
+
+#define CHECK(cond) \
+	do { \
+		if(!(cond)) { \
+			elm::cerr << __FILE__ << ':' << __LINE__ << ": FAILED: " << #cond << elm::io::endl; \
+			failed++; \
+		} \
+	} while(0)
+
+#define CHECK_EQUAL(res, ref)	CHECK((res) == (ref))
+
+#endif /* GELPP_TEST_CHECK_H_ */
@@ -0,0 +1,33 @@
+/*
+ * GEL++ library used to test the decoding of debug line information
+ * Copyright (c) 2020, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef GELPP_TEST_DWARF_LIB_H_
+#define GELPP_TEST_DWARF_LIB_H_
+
+// inlined in both units to get rows from several files
+static inline int gel_test_mix(int x, int y) {
+	if(x > y)
+		return x * 3 - y;
+	else
+		return y * 5 + x;
+}
+
+extern "C" int gel_test_sum(int n);
+extern "C" int gel_test_fact(int n);
+
+#endif /* GELPP_TEST_DWARF_LIB_H_ */
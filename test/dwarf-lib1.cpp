@@ -0,0 +1,32 @@
+/*
+ * GEL++ library used to test the decoding of debug line information
+ * Copyright (c) 2020, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "dwarf-lib.h"
+
+// same name as in dwarf-lib2.cpp
+static int gel_test_step(int x) {
+	return gel_test_mix(x, 7) + 1;
+}
+
+extern "C" int gel_test_sum(int n) {
+	int s = 0;
+	for(int i = 0; i < n; i++)
+		s += gel_test_step(i);
+	return s;
+}
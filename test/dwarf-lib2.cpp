@@ -0,0 +1,34 @@
+/*
+ * GEL++ library used to test the decoding of debug line information
+ * Copyright (c) 2020, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "dwarf-lib.h"
+
+// same name as in dwarf-lib1.cpp
+static int gel_test_step(int x) {
+	return gel_test_mix(11, x) - 1;
+}
+
+extern "C" int gel_test_fact(int n) {
+	int r = 1;
+	while(n > 1) {
+		r *= gel_test_step(n);
+		n--;
+	}
+	return r + gel_test_sum(n);
+}
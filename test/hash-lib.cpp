@@ -0,0 +1,29 @@
+/*
+ * GEL++ library used to test the hashed lookup of dynamic symbols
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+// enough symbols to get several symbols per bucket
+#define FUN(n)	extern "C" int gel_test_fun##n(int x) { return x + n; }
+#define VAR(n)	extern "C" { int gel_test_var##n = n; }
+#define DEF(n)	FUN(n) VAR(n)
+#define DEF8(n)	DEF(n##0) DEF(n##1) DEF(n##2) DEF(n##3) DEF(n##4) DEF(n##5) DEF(n##6) DEF(n##7)
+
+DEF8(1)
+DEF8(2)
+DEF8(3)
+DEF8(4)
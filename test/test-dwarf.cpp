@@ -0,0 +1,191 @@
+/*
+ * GEL++ test of the decoding of debug line information
+ * Copyright (c) 2020, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++.h>
+#include <gel++/DebugLine.h>
+#include <gel++/elf/DebugLine.h>
+#include <gel++/elf/File.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+typedef DebugLine::LineNumber LineNumber;
+
+/**
+ * Test if two rows are the same. The files may be different objects
+ * but must have the same path.
+ */
+static bool same(const LineNumber& l1, const LineNumber& l2) {
+	if(l1.file() == nullptr || l2.file() == nullptr)
+		return l1.file() == l2.file();
+	return l1.addr() == l2.addr()
+		&& l1.line() == l2.line()
+		&& l1.col() == l2.col()
+		&& l1.flags() == l2.flags()
+		&& l1.file()->path() == l2.file()->path();
+}
+
+/**
+ * Compare the rows passed by elf::DebugLine::visit() with the rows of the
+ * eager decoding (the files of the visitor are released at unit end).
+ */
+class Checker: public DebugLine::Visitor {
+public:
+	inline Checker(const Vector<LineNumber>& rows): _rows(rows), _i(0) { }
+	inline int count() const { return _i; }
+
+	void processLine(const DebugLine::CompilationUnit& cu, const LineNumber& line) override {
+		CHECK(_i < _rows.count());
+		if(_i < _rows.count())
+			CHECK(same(line, _rows[_i]));
+		_i++;
+	}
+
+private:
+	const Vector<LineNumber>& _rows;
+	int _i;
+};
+
+/**
+ * Check the lookups in the given file opened with the given flags against
+ * the reference lines.
+ * @param path		Path of the file.
+ * @param flags		Manager flags.
+ * @param addrs		Looked addresses.
+ * @param refs		Reference lines of the looked addresses.
+ */
+static void check(sys::Path path, Manager::flags_t flags, const Vector<address_t>& addrs, const Vector<LineNumber>& refs) {
+	int old = failed;
+	Manager man(flags);
+	File *file = man.openFile(path);
+	DebugLine *dl = file->debugLines();
+	CHECK(dl != nullptr);
+	if(dl != nullptr) {
+
+		// single lookups
+		for(int i = 0; i < addrs.count(); i++) {
+			LineNumber l;
+			CHECK_EQUAL(dl->lineAt(addrs[i], l), refs[i].file() != nullptr);
+			CHECK(same(l, refs[i]));
+		}
+
+		// batch lookup, in reverse order
+		Vector<address_t> raddrs;
+		for(int i = addrs.count() - 1; i >= 0; i--)
+			raddrs.add(addrs[i]);
+		Vector<LineNumber> ls;
+		dl->linesAt(raddrs, ls);
+		CHECK_EQUAL(ls.count(), addrs.count());
+		for(int i = 0; i < ls.count(); i++)
+			CHECK(same(ls[i], refs[addrs.count() - 1 - i]));
+	}
+	delete file;
+	if(failed != old)
+		cerr << "with flags " << io::hex(flags) << io::endl;
+}
+
+/**
+ * Check that the lookups agree whatever the decoding mode of the debug line
+ * information of a small library (built with DWARF 4 or 5).
+ * Usage: test-dwarf <library path>
+ */
+int main(int argc, char **argv) {
+	if(argc != 2) {
+		cerr << "ERROR: no library given.\n";
+		return 1;
+	}
+	try {
+		Manager man;
+		File *file = man.openFile(argv[1]);
+		DebugLine *dl = file->debugLines();
+		CHECK(dl != nullptr);
+		if(dl == nullptr)
+			return failed;
+
+		// collect the rows and the looked addresses (row bounds and outside)
+		Vector<LineNumber> rows;
+		Vector<address_t> addrs;
+		address_t top = 0;
+		for(auto cu: dl->units()) {
+			const auto& lines = cu->lines();
+			for(int i = 0; i < lines.count(); i++) {
+				rows.add(lines[i]);
+				if(i < lines.count() - 1 && !(lines[i].flags() & LineNumber::END_SEQUENCE)) {
+					addrs.add(lines[i].addr());
+					if(lines[i + 1].addr() > lines[i].addr())
+						addrs.add(lines[i + 1].addr() - 1);
+				}
+			}
+			top = max(top, cu->topAddress());
+		}
+		CHECK(dl->units().count() >= 2);
+		CHECK(addrs.count() != 0);
+		addrs.add(0);
+		addrs.add(top);
+		addrs.add(top + 0x1000);
+		Vector<LineNumber> refs;
+		for(auto a: addrs) {
+			LineNumber l;
+			dl->lineAt(a, l);
+			refs.add(l);
+		}
+
+		// a file must record its units and its ranges once (DWARF 5 file 0 and 1)
+		for(auto f: dl->files()) {
+			for(auto u: f->units()) {
+				int c = 0;
+				for(auto v: f->units())
+					if(v == u)
+						c++;
+				CHECK_EQUAL(c, 1);
+			}
+			int n = f->countRanges();
+			for(int i = 0; i < n; i++)
+				if(f->range(i).low < f->range(i).high)
+					for(int j = i + 1; j < n && f->range(j).line == f->range(i).line; j++)
+						CHECK(f->range(j).low != f->range(i).low || f->range(j).high != f->range(i).high);
+		}
+
+		// same lines whatever the decoding mode
+		static const Manager::flags_t flags[] = {
+			0,
+			Manager::LAZY_DEBUG_LINES,
+			Manager::PARALLEL_DEBUG_LINES,
+			Manager::COMPACT_DEBUG_LINES,
+			Manager::LAZY_DEBUG_LINES | Manager::PARALLEL_DEBUG_LINES,
+			Manager::LAZY_DEBUG_LINES | Manager::COMPACT_DEBUG_LINES,
+			Manager::PARALLEL_DEBUG_LINES | Manager::COMPACT_DEBUG_LINES,
+			Manager::LAZY_DEBUG_LINES | Manager::PARALLEL_DEBUG_LINES | Manager::COMPACT_DEBUG_LINES
+		};
+		for(auto f: flags)
+			check(argv[1], f, addrs, refs);
+
+		// same rows when visited
+		Checker checker(rows);
+		elf::DebugLine::visit(file->toELF(), checker);
+		CHECK_EQUAL(checker.count(), rows.count());
+		delete file;
+	}
+	catch(gel::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+		return 1;
+	}
+	return failed;
+}
@@ -0,0 +1,72 @@
+/*
+ * GEL++ test of the hashed lookup of dynamic symbols
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++.h>
+#include <gel++/elf/File.h>
+#include <gel++/elf/FlatSymbolTable.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+/**
+ * Compare the lookup through the hash section of the given library
+ * with a linear scan of its dynamic symbol table.
+ * Usage: test-hash <library path>
+ */
+int main(int argc, char **argv) {
+	if(argc != 2) {
+		cerr << "ERROR: no library given.\n";
+		return 1;
+	}
+	try {
+		File *file = Manager::open(argv[1]);
+		elf::File *elf = file->toELF();
+		CHECK(elf != nullptr);
+		if(elf == nullptr)
+			return failed;
+
+		// every defined global test symbol (from .symtab or .dynsym) must be
+		// found with the same value
+		int found = 0;
+		for(auto sym: elf->flatSymbols()) {
+			if(sym.shndx() == SHN_UNDEF || sym.elfBind() == STB_LOCAL
+			|| !sym.name().startsWith("gel_test_"))
+				continue;
+			elf::File::sym_t hsym;
+			CHECK(elf->findDynamic(sym.name(), hsym));
+			CHECK_EQUAL(hsym.value, sym.value());
+			CHECK_EQUAL(hsym.size, sym.size());
+			found++;
+		}
+		CHECK(found >= 64);
+
+		// unknown and undefined names must not be found
+		elf::File::sym_t sym;
+		CHECK(!elf->findDynamic("gel_test_none", sym));
+		CHECK(!elf->findDynamic("gel_test_fun", sym));
+		CHECK(!elf->findDynamic("", sym));
+		delete file;
+	}
+	catch(gel::Exception& e) {
+		cerr << "ERROR: " << e.message() << io::endl;
+		return 1;
+	}
+	return failed;
+}
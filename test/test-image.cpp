@@ -0,0 +1,128 @@
+/*
+ * GEL++ test of the typed memory access of Image
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++/Image.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+/**
+ * Decoder of big-endian data on a little-endian host (and conversely).
+ */
+class SwapDecoder: public Decoder {
+public:
+	void fix(t::uint16& w) override { swap(w); }
+	void fix(t::int16& w) override { swap(w); }
+	void fix(t::uint32& w) override { swap(w); }
+	void fix(t::int32& w) override { swap(w); }
+	void fix(t::uint64& w) override { swap(w); }
+	void fix(t::int64& w) override { swap(w); }
+	void unfix(t::uint16& w) override { swap(w); }
+	void unfix(t::int16& w) override { swap(w); }
+	void unfix(t::uint32& w) override { swap(w); }
+	void unfix(t::int32& w) override { swap(w); }
+	void unfix(t::uint64& w) override { swap(w); }
+	void unfix(t::int64& w) override { swap(w); }
+private:
+	template <class T> static void swap(T& w) {
+		t::uint8 *p = reinterpret_cast<t::uint8 *>(&w);
+		for(size_t i = 0; i < sizeof(T) / 2; i++) {
+			t::uint8 b = p[i];
+			p[i] = p[sizeof(T) - 1 - i];
+			p[sizeof(T) - 1 - i] = b;
+		}
+	}
+};
+
+int main() {
+	SwapDecoder dec;
+	t::uint8 *a = new t::uint8[0x2000], *b = new t::uint8[0x1000];
+	array::set(a, 0x2000, t::uint8(0));
+	array::set(b, 0x1000, t::uint8(0));
+	static t::uint8 shared[0x2000];
+	for(int i = 0; i < 0x2000; i++)
+		shared[i] = i;
+	ImageSegment *sa = new ImageSegment(Buffer(&dec, a, 0x2000), 0x1000, ImageSegment::WRITABLE | ImageSegment::TO_FREE, "a");
+	ImageSegment *sb = new ImageSegment(Buffer(&dec, b, 0x1000), 0x3000, ImageSegment::WRITABLE | ImageSegment::TO_FREE, "b");
+	ImageSegment *ss = new ImageSegment(Buffer(&dec, shared, 0x2000), 0x8000, ImageSegment::WRITABLE | ImageSegment::SHARED, "shared");
+	{
+		Image im(nullptr);
+		im.add(sa);
+		im.add(sb);
+		im.add(ss);
+
+		// big-endian access inside a segment (the second read uses the translation cache)
+		im.write<t::uint32>(0x1010, 0x11223344);
+		CHECK(a[0x10] == 0x11 && a[0x11] == 0x22 && a[0x12] == 0x33 && a[0x13] == 0x44);
+		CHECK_EQUAL(im.read<t::uint32>(0x1010), t::uint32(0x11223344));
+		CHECK_EQUAL(im.read<t::uint32>(0x1010), t::uint32(0x11223344));
+		CHECK_EQUAL(im.read<t::uint16>(0x1012), t::uint16(0x3344));
+		CHECK_EQUAL(im.read<t::uint8>(0x1011), t::uint8(0x22));
+		im.write<t::int16>(0x1020, -2);
+		CHECK_EQUAL(im.read<t::int16>(0x1020), t::int16(-2));
+
+		// across a page boundary inside a segment
+		im.write<t::uint64>(0x1ffc, 0x0102030405060708ULL);
+		CHECK(a[0xffc] == 0x01 && a[0xfff] == 0x04 && a[0x1000] == 0x05 && a[0x1003] == 0x08);
+		CHECK_EQUAL(im.read<t::uint64>(0x1ffc), t::uint64(0x0102030405060708ULL));
+
+		// across a segment boundary
+		im.write<t::uint32>(0x2ffe, 0xaabbccdd);
+		CHECK(a[0x1ffe] == 0xaa && a[0x1fff] == 0xbb && b[0] == 0xcc && b[1] == 0xdd);
+		CHECK_EQUAL(im.read<t::uint32>(0x2ffe), t::uint32(0xaabbccdd));
+		t::uint8 buf[4];
+		im.read(0x2ffe, buf, sizeof(buf));
+		CHECK(buf[0] == 0xaa && buf[1] == 0xbb && buf[2] == 0xcc && buf[3] == 0xdd);
+
+		// outside of any segment
+		bool thrown = false;
+		try {
+			im.read<t::uint32>(0x5000);
+		}
+		catch(gel::Exception& e) {
+			thrown = true;
+		}
+		CHECK(thrown);
+		thrown = false;
+		try {
+			im.read<t::uint32>(0x3ffe);
+		}
+		catch(gel::Exception& e) {
+			thrown = true;
+		}
+		CHECK(thrown);
+
+		// copy-on-write of a shared segment
+		CHECK_EQUAL(im.read<t::uint8>(0x9001), t::uint8(0x01));
+		im.write<t::uint8>(0x9001, 0xff);
+		CHECK_EQUAL(im.read<t::uint8>(0x9001), t::uint8(0xff));
+		CHECK_EQUAL(shared[0x1001], t::uint8(0x01));
+		CHECK_EQUAL(ss->copiedPages(), 1);
+		CHECK_EQUAL(im.read<t::uint16>(0x8ffe), t::uint16(0xfeff));
+		im.write<t::uint16>(0x8ffe, 0x1234);
+		CHECK_EQUAL(im.read<t::uint16>(0x8ffe), t::uint16(0x1234));
+		CHECK_EQUAL(shared[0xffe], t::uint8(0xfe));
+		CHECK_EQUAL(ss->copiedPages(), 2);
+	}
+	delete sa;
+	delete sb;
+	delete ss;
+	return failed;
+}
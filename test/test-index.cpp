@@ -0,0 +1,88 @@
+/*
+ * GEL++ test of IntervalIndex
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++/IntervalIndex.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+/**
+ * Find by a linear scan the interval with the greatest start address
+ * containing a.
+ */
+static int scan(const IntervalIndex<int>& index, address_t a) {
+	int r = -1;
+	for(int i = 0; i < index.count(); i++)
+		if(index.low(i) <= a && a < index.high(i))
+			r = i;
+	return r;
+}
+
+int main() {
+	IntervalIndex<int> index;
+
+	// empty index
+	index.build();
+	CHECK_EQUAL(index.count(), 0);
+	CHECK_EQUAL(index.find(0x100), -1);
+
+	// overlapping and disjoint intervals (added out of order)
+	index.add(0x200, 0x300, 4);
+	index.add(0x000, 0x100, 1);
+	index.add(0x050, 0x150, 3);
+	index.add(0x010, 0x020, 2);
+	index.add(0x400, 0x400, 5);
+	index.build();
+	CHECK_EQUAL(index.count(), 5);
+	for(int i = 1; i < index.count(); i++)
+		CHECK(index.low(i - 1) <= index.low(i));
+
+	// single lookups
+	CHECK_EQUAL(index.data(index.find(0x000)), 1);
+	CHECK_EQUAL(index.data(index.find(0x015)), 2);
+	CHECK_EQUAL(index.data(index.find(0x020)), 1);
+	CHECK_EQUAL(index.data(index.find(0x060)), 3);
+	CHECK_EQUAL(index.data(index.find(0x120)), 3);
+	CHECK_EQUAL(index.find(0x150), -1);
+	CHECK_EQUAL(index.find(0x1ff), -1);
+	CHECK_EQUAL(index.data(index.find(0x2ff)), 4);
+	CHECK_EQUAL(index.find(0x300), -1);
+	CHECK_EQUAL(index.find(0x400), -1);
+
+	// all addresses compared with a linear scan, one by one and in batch
+	const int n = 0x500;
+	address_t addrs[n];
+	int res[n];
+	for(int i = 0; i < n; i++)
+		addrs[i] = (i * 7) % n;
+	index.findAll(addrs, n, res);
+	for(int i = 0; i < n; i++) {
+		CHECK_EQUAL(index.find(addrs[i]), scan(index, addrs[i]));
+		CHECK_EQUAL(res[i], scan(index, addrs[i]));
+	}
+
+	// rebuild from scratch
+	index.add(0x1000, 0x2000, 6);
+	index.build();
+	CHECK_EQUAL(index.count(), 1);
+	CHECK_EQUAL(index.find(0x015), -1);
+	CHECK_EQUAL(index.data(index.find(0x1fff)), 6);
+	return failed;
+}
@@ -0,0 +1,115 @@
+/*
+ * GEL++ test of the line sequences
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++/DebugLine.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+typedef DebugLine::LineNumber LineNumber;
+
+/**
+ * Add the rows of three sequences, out of address order, and of an
+ * empty sequence.
+ */
+static void fill(DebugLine::CompilationUnit& cu, DebugLine::File *f) {
+	cu.add(f);
+	cu.add(LineNumber(0x200, f, 10, 0, LineNumber::IS_STMT));
+	cu.add(LineNumber(0x208, f, 11, 0, LineNumber::IS_STMT, 0, 3));
+	cu.add(LineNumber(0x210, f, 11, 0, LineNumber::END_SEQUENCE));
+	cu.add(LineNumber(0x100, f, 1, 0, LineNumber::IS_STMT));
+	cu.add(LineNumber(0x104, f, 2, 4, LineNumber::IS_STMT));
+	cu.add(LineNumber(0x108, f, 2, 0, LineNumber::END_SEQUENCE));
+	cu.add(LineNumber(0x180, f, 5, 0, LineNumber::IS_STMT));
+	cu.add(LineNumber(0x190, f, 5, 0, LineNumber::END_SEQUENCE));
+	cu.add(LineNumber(0x400, f, 7, 0, LineNumber::IS_STMT));
+	cu.add(LineNumber(0x400, f, 7, 0, LineNumber::END_SEQUENCE));
+}
+
+/**
+ * Check the lookups in a unit filled by fill().
+ */
+static void check(const DebugLine::CompilationUnit& cu, DebugLine::File *f) {
+	CHECK_EQUAL(cu.find(0x0ff), -1);
+	CHECK_EQUAL(cu.find(0x100), 3);
+	CHECK_EQUAL(cu.find(0x106), 4);
+	CHECK_EQUAL(cu.find(0x108), -1);
+	CHECK_EQUAL(cu.find(0x150), -1);
+	CHECK_EQUAL(cu.find(0x18f), 6);
+	CHECK_EQUAL(cu.find(0x20c), 1);
+	CHECK_EQUAL(cu.find(0x210), -1);
+	CHECK_EQUAL(cu.find(0x400), -1);
+	LineNumber l;
+	CHECK(cu.lineAt(0x106, l));
+	CHECK_EQUAL(l.line(), 2);
+	CHECK_EQUAL(l.col(), 4);
+	CHECK(l.file() == f);
+	CHECK(cu.lineAt(0x20c, l));
+	CHECK_EQUAL(l.line(), 11);
+	CHECK_EQUAL(l.discriminator(), 3);
+	CHECK(!cu.lineAt(0x150, l));
+}
+
+int main() {
+	DebugLine::File f("test.c");
+
+	// sequences split on END_SEQUENCE and sorted by address
+	{
+		DebugLine::CompilationUnit cu;
+		fill(cu, &f);
+		CHECK_EQUAL(cu.countSequences(), 3);
+		CHECK_EQUAL(cu.sequence(0).base(), address_t(0x100));
+		CHECK_EQUAL(cu.sequence(0).top(), address_t(0x108));
+		CHECK_EQUAL(cu.sequence(1).base(), address_t(0x180));
+		CHECK_EQUAL(cu.sequence(1).top(), address_t(0x190));
+		CHECK_EQUAL(cu.sequence(2).base(), address_t(0x200));
+		CHECK_EQUAL(cu.sequence(2).top(), address_t(0x210));
+		CHECK_EQUAL(cu.baseAddress(), address_t(0x100));
+		CHECK_EQUAL(cu.topAddress(), address_t(0x210));
+		check(cu, &f);
+		const LineNumber *l = cu.lineAt(0x106);
+		CHECK(l == &cu.lines()[4]);
+		CHECK(cu.lineAt(0x150) == nullptr);
+	}
+
+	// same lookups in compact form
+	{
+		DebugLine::CompilationUnit cu;
+		fill(cu, &f);
+		cu.compact();
+		CHECK(cu.table().isCompact());
+		CHECK_EQUAL(cu.table().count(), 11);
+		CHECK_EQUAL(cu.countSequences(), 3);
+		check(cu, &f);
+	}
+
+	// rows after the last sequence end form an unterminated sequence
+	{
+		DebugLine::CompilationUnit cu;
+		cu.add(&f);
+		cu.add(LineNumber(0x300, &f, 1));
+		cu.add(LineNumber(0x304, &f, 2));
+		cu.add(LineNumber(0x308, &f, 3));
+		CHECK_EQUAL(cu.countSequences(), 1);
+		CHECK_EQUAL(cu.find(0x306), 1);
+		CHECK_EQUAL(cu.find(0x308), -1);
+	}
+	return failed;
+}
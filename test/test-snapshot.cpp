@@ -0,0 +1,83 @@
+/*
+ * GEL++ test of the image snapshots
+ * Copyright (c) 2016, IRIT- université de Toulouse
+ *
+ * GEL++ is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GEL++ is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with GEL++; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gel++/Image.h>
+#include "check.h"
+
+using namespace elm;
+using namespace gel;
+
+static const size_t PAGE = 1 << Image::PAGE_BITS;
+
+int main() {
+	t::uint8 *w = new t::uint8[3 * PAGE];
+	array::set(w, 3 * PAGE, t::uint8(0));
+	for(size_t i = 0; i < PAGE; i++) {
+		w[i] = i + 1;
+		w[2 * PAGE + i] = i + 2;
+	}
+	static t::uint8 shared[PAGE] = { 0x55 };
+	ImageSegment *sw = new ImageSegment(Buffer(nullptr, w, 3 * PAGE), 0x10000, ImageSegment::WRITABLE | ImageSegment::TO_FREE, "w");
+	ImageSegment *ss = new ImageSegment(Buffer(nullptr, shared, PAGE), 0x20000, ImageSegment::WRITABLE | ImageSegment::SHARED, "shared");
+	{
+		Image im(nullptr);
+		im.add(sw);
+		im.add(ss);
+
+		// full round-trip
+		Image::Snapshot *s1 = im.snapshot();
+		im.write<t::uint32>(0x10000, 0xffffffff);
+		im.write<t::uint32>(0x10000 + PAGE + 8, 0x12345678);
+		im.write<t::uint32>(0x10000 + 2 * PAGE - 2, 0xdeadbeef);
+		im.write<t::uint8>(0x20000, 0x66);
+		im.restore(s1);
+		CHECK(w[0] == 1 && w[1] == 2 && w[2] == 3 && w[3] == 4);
+		CHECK(w[PAGE - 2] == 0xff && w[PAGE - 1] == 0);
+		CHECK(w[PAGE + 8] == 0 && w[2 * PAGE - 1] == 0);
+		CHECK(w[2 * PAGE] == 2 && w[2 * PAGE + 1] == 3);
+		CHECK_EQUAL(im.read<t::uint8>(0x20000), t::uint8(0x55));
+		CHECK_EQUAL(shared[0], t::uint8(0x55));
+
+		// only the dirty pages are copied back
+		im.write<t::uint8>(0x10000 + PAGE, 0x77);
+		w[0] = 0x88;
+		im.restore(s1);
+		CHECK_EQUAL(w[PAGE], t::uint8(0));
+		CHECK_EQUAL(w[0], t::uint8(0x88));
+		w[0] = 1;
+
+		// switching between snapshots copies back the whole segments
+		im.write<t::uint8>(0x10000 + 2 * PAGE, 0x99);
+		Image::Snapshot *s2 = im.snapshot();
+		im.write<t::uint8>(0x10000 + 2 * PAGE, 0xaa);
+		im.restore(s1);
+		CHECK_EQUAL(im.read<t::uint8>(0x10000 + 2 * PAGE), t::uint8(2));
+		im.restore(s2);
+		CHECK_EQUAL(im.read<t::uint8>(0x10000 + 2 * PAGE), t::uint8(0x99));
+		CHECK_EQUAL(im.read<t::uint8>(0x10000), t::uint8(1));
+		im.restore(s1);
+		CHECK_EQUAL(im.read<t::uint8>(0x10000 + 2 * PAGE), t::uint8(2));
+
+		delete s2;
+		delete s1;
+	}
+	delete sw;
+	delete ss;
+	return failed;
+}